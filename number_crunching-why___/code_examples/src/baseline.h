@@ -0,0 +1,236 @@
+#ifndef BASELINE_H_
+#define BASELINE_H_
+
+// Stored baselines and regression detection for the benchmark runner.
+//
+// A baseline file is plain text, one measured cell per line:
+//   name, cache, heap, input, elements, time_us, time_us, ...
+//   linear_insert/vector/POD<4>, as-is, fresh, uniform, 1000, 223, 230, 219
+// with one time per repetition. Lines starting with '#' are comments.
+//
+// Only cells that were measured are saved. When comparing, every cell of the baseline
+// that is part of the current run is tracked: every selected cell and element count is
+// in the current results, measured or not. A tracked cell that was not measured this
+// time, it timed out, failed or was skipped over the time budget, is missing and fails
+// the comparison like a regression. A measured tracked cell regresses when its median
+// is more than 'threshold' slower AND a one sided
+// Mann-Whitney U test says that the new times are larger than the baseline times with
+// p < alpha. The rank test needs no assumptions about the noise, but with fewer than
+// kMinSamplesForTest samples on either side it cannot tell noise from a change; such
+// cells are flagged on the threshold alone and marked as untested. Use --reps=5 or
+// more for both the baseline and the comparison.
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+
+const size_t kMinSamplesForTest = 3;
+
+
+// All repetitions of one cell at one element count, in one cache/heap/input variant.
+// 'status' is "ok" when it was measured, else why not, e.g. "timeout" or "skipped",
+// and there are no samples
+struct CellSamples
+{
+  std::string name;
+  std::string cache;
+  std::string heap;
+  std::string input;
+  size_t nbr_of_elements;
+  std::string status;
+  std::vector<TimeValue> samples;
+
+  CellSamples() : nbr_of_elements(0), status("ok") {}
+
+  bool measured() const { return "ok" == status; }
+
+  std::string key() const
+  {
+    std::ostringstream oss;
+    oss << name << ", " << cache << ", " << heap << ", " << input << ", " << nbr_of_elements;
+    return oss.str();
+  }
+};
+typedef std::vector<CellSamples> BaselineResults;
+
+
+double medianOf(std::vector<TimeValue> samples)
+{
+  if (samples.empty()) {
+    return 0;
+  }
+  std::sort(samples.begin(), samples.end());
+  const size_t middle = samples.size() / 2;
+  return (samples.size() % 2) ? double(samples[middle]) : (samples[middle - 1] + samples[middle]) / 2.0;
+}
+
+// One sided Mann-Whitney U test: p-value for "current tends to be larger than baseline".
+// Normal approximation with continuity correction, ties count as half
+double mannWhitneyGreaterP(const std::vector<TimeValue>& baseline, const std::vector<TimeValue>& current)
+{
+  const double n1 = double(current.size());
+  const double n2 = double(baseline.size());
+  double u = 0;
+  for (auto now : current)
+  {
+    for (auto before : baseline) {
+      u += (now > before) ? 1.0 : (now == before) ? 0.5 : 0.0;
+    }
+  }
+  const double mean = n1 * n2 / 2;
+  const double deviation = std::sqrt(n1 * n2 * (n1 + n2 + 1) / 12);
+  const double z = (u - mean - 0.5) / deviation;
+  return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+
+// 'notes' are written first and should be '#' comment lines, e.g. the memory profile
+// of the host (memory_probe.h) that the numbers were measured on
+void writeBaseline(std::ostream& out, const BaselineResults& results, const std::string& notes = "")
+{
+  out << notes;
+  out << "# name, cache, heap, input, elements, time_us per repetition" << std::endl;
+  for (auto& cell : results)
+  {
+    if (!cell.measured()) {
+      continue;
+    }
+    out << cell.key();
+    for (auto sample : cell.samples) {
+      out << ", " << sample;
+    }
+    out << std::endl;
+  }
+}
+
+bool writeBaseline(const std::string& path, const BaselineResults& results, const std::string& notes = "")
+{
+  std::ofstream out(path.c_str());
+  writeBaseline(out, results, notes);
+  return bool(out);
+}
+
+// Returns false, after printing where, when the file cannot be read or a line is malformed
+bool readBaseline(const std::string& path, BaselineResults& results)
+{
+  std::ifstream in(path.c_str());
+  if (!in) {
+    std::cout << "Cannot read baseline " << path << std::endl;
+    return false;
+  }
+  std::string line;
+  size_t line_nbr = 0;
+  while (std::getline(in, line))
+  {
+    ++line_nbr;
+    if (line.empty() || '#' == line[0]) {
+      continue;
+    }
+    std::vector<std::string> fields;
+    std::istringstream iss(line);
+    std::string field;
+    while (std::getline(iss, field, ',')) {
+      const size_t first = field.find_first_not_of(" \t");
+      fields.push_back(first == std::string::npos ? "" : field.substr(first));
+    }
+
+    CellSamples cell;
+    bool ok = fields.size() > 5;
+    if (ok)
+    {
+      cell.name = fields[0];
+      cell.cache = fields[1];
+      cell.heap = fields[2];
+      cell.input = fields[3];
+      std::istringstream elements(fields[4]);
+      ok = bool(elements >> cell.nbr_of_elements);
+      for (size_t idx = 5; ok && idx != fields.size(); ++idx)
+      {
+        std::istringstream sample(fields[idx]);
+        TimeValue time_us = 0;
+        ok = bool(sample >> time_us);
+        cell.samples.push_back(time_us);
+      }
+    }
+    if (!ok) {
+      std::cout << "Malformed baseline line " << path << ":" << line_nbr << ": " << line << std::endl;
+      return false;
+    }
+    results.push_back(cell);
+  }
+  return true;
+}
+
+
+// Print the comparison of every tracked cell. Returns the number of regressions and
+// missing cells
+size_t compareWithBaseline(const BaselineResults& baseline, const BaselineResults& current,
+                           const double threshold_percent, const double alpha)
+{
+  std::map<std::string, const CellSamples*> measured;
+  for (auto& cell : current) {
+    measured[cell.key()] = &cell;
+  }
+
+  size_t tracked = 0;
+  size_t regressions = 0;
+  size_t missing = 0;
+  std::cout << "Comparison against the baseline: slower by more than " << threshold_percent;
+  std::cout << "% and p < " << alpha << " is a regression" << std::endl;
+  std::cout << "name, cache, heap, input, elements,\tbaseline_us,\tcurrent_us,\tchange%,\tp,\tverdict" << std::endl;
+  for (auto& before : baseline)
+  {
+    auto found = measured.find(before.key());
+    if (found == measured.end()) {
+      continue; // not run this time
+    }
+    const CellSamples& now = *found->second;
+    ++tracked;
+    if (!now.measured())
+    {
+      ++missing;
+      std::cout << before.key() << ",\t" << medianOf(before.samples) << ",\t-,\t-,\t-,\tMISSING (";
+      std::cout << now.status << ")" << std::endl;
+      continue;
+    }
+
+    const double median_before = medianOf(before.samples);
+    const double median_now = medianOf(now.samples);
+    const double change = (median_before > 0) ? 100.0 * (median_now - median_before) / median_before
+                                              : (median_now > 0 ? 100.0 : 0.0);
+    const bool testable = before.samples.size() >= kMinSamplesForTest && now.samples.size() >= kMinSamplesForTest;
+    const double p = testable ? mannWhitneyGreaterP(before.samples, now.samples) : 0;
+
+    std::string verdict = "ok";
+    if (change > threshold_percent && (!testable || p < alpha)) {
+      verdict = testable ? "REGRESSION" : "REGRESSION (untested)";
+      ++regressions;
+    } else if (change > threshold_percent) {
+      verdict = "noise";
+    } else if (change < -threshold_percent) {
+      verdict = "faster";
+    }
+
+    std::cout << before.key() << ",\t" << median_before << ",\t" << median_now << ",\t";
+    std::cout << std::fixed << std::setprecision(1) << change << ",\t";
+    if (testable) {
+      std::cout << std::setprecision(3) << p;
+    } else {
+      std::cout << "-";
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6) << ",\t" << verdict << std::endl;
+  }
+  std::cout << tracked << " of " << baseline.size() << " baseline cells tracked, ";
+  std::cout << regressions << " regressions, " << missing << " missing" << std::endl;
+  return regressions + missing;
+}
+
+#endif // BASELINE_H_
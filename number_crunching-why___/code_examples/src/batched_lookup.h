@@ -0,0 +1,202 @@
+#ifndef BATCHED_LOOKUP_H_
+#define BATCHED_LOOKUP_H_
+
+// Batched lookups: 'Width' searches run interleaved, each one a small hand written
+// state machine (a cursor) that does the work of one node and then prefetches the
+// next node before it gives way to the next search. A single search over a list or a
+// tree is one chain of dependent loads, the core waits for every miss. With 'Width'
+// chains in flight the misses overlap, i.e. the memory level parallelism of the core
+// is used. Width 1 is the plain one search at a time.
+//
+// A lookup finds the first element with a key >= the searched key (keyOf), in
+//   std::list     sorted, walked node by node. The walks of one batch also share the
+//                 nodes at the front of the list, a node one walk missed on is in
+//                 the cache for the walks behind it
+//   std::vector   sorted, binary search, the next probe is prefetched
+//   SearchBTree   one node per level (search_btree.h)
+//
+// buildSorted fills the container, interleavedLookup runs the batches.
+// Include "pod_performance.h", "cache_mode.h", "kv_performance.h" and "search_btree.h"
+// before this file.
+
+#include <list>
+#include <vector>
+#include <algorithm>
+
+
+template<typename Container>
+class LookupCursor;
+
+// Walk of a sorted list
+template<typename T>
+class LookupCursor<std::list<T>>
+{
+  typename std::list<T>::const_iterator at_;
+  typename std::list<T>::const_iterator end_;
+  Number key_;
+
+public:
+  void start(const std::list<T>& list, const Number key)
+  {
+    at_ = list.begin();
+    end_ = list.end();
+    key_ = key;
+    if (at_ != end_) {
+      prefetchLines(&*at_, sizeof(T));
+    }
+  }
+
+  bool step()
+  {
+    if (at_ == end_ || keyOf(*at_) >= key_) {
+      return true;
+    }
+    ++at_;
+    if (at_ != end_) {
+      prefetchLines(&*at_, sizeof(T));
+    }
+    return false;
+  }
+
+  const T* found() const { return (at_ == end_) ? nullptr : &*at_; }
+};
+
+// Binary search of a sorted vector
+template<typename T>
+class LookupCursor<std::vector<T>>
+{
+  const T* data_;
+  size_t size_;
+  size_t first_;
+  size_t length_;
+  Number key_;
+
+public:
+  void start(const std::vector<T>& vector, const Number key)
+  {
+    data_ = vector.data();
+    size_ = vector.size();
+    first_ = 0;
+    length_ = size_;
+    key_ = key;
+    if (length_ > 0) {
+      prefetchLines(data_ + length_ / 2, sizeof(T));
+    }
+  }
+
+  bool step()
+  {
+    if (0 == length_) {
+      return true;
+    }
+    const size_t half = length_ / 2;
+    if (keyOf(data_[first_ + half]) < key_)
+    {
+      first_ += half + 1;
+      length_ -= half + 1;
+    }
+    else
+    {
+      length_ = half;
+    }
+    if (length_ > 0) {
+      prefetchLines(data_ + first_ + length_ / 2, sizeof(T));
+    }
+    return 0 == length_;
+  }
+
+  const T* found() const { return (first_ == size_) ? nullptr : data_ + first_; }
+};
+
+// Root to leaf in the B+tree
+template<typename T, size_t Fanout>
+class LookupCursor<SearchBTree<Number, T, Fanout>>
+{
+  typedef SearchBTree<Number, T, Fanout> Tree;
+  typename Tree::Search search_;
+
+  void prefetchPending()
+  {
+    if (nullptr != search_.pending()) {
+      prefetchLines(search_.pending(), search_.pendingBytes());
+    }
+  }
+
+public:
+  void start(const Tree& tree, const Number key)
+  {
+    search_.start(tree, key);
+    prefetchPending();
+  }
+
+  bool step()
+  {
+    const bool done = search_.step();
+    prefetchPending();
+    return done;
+  }
+
+  const T* found() const { return search_.found(); }
+};
+
+
+// The containers sorted on the key, for the lookups
+template<typename Values, typename T>
+void buildSorted(const Values& values, std::vector<T>& vector)
+{
+  vector.assign(values.begin(), values.end());
+  std::stable_sort(vector.begin(), vector.end(), [](const T& a, const T& b) { return keyOf(a) < keyOf(b); });
+}
+
+template<typename Values, typename T>
+void buildSorted(const Values& values, std::list<T>& list)
+{
+  list.assign(values.begin(), values.end());
+  list.sort([](const T& a, const T& b) { return keyOf(a) < keyOf(b); });
+}
+
+template<typename Values, typename T, size_t Fanout>
+void buildSorted(const Values& values, SearchBTree<Number, T, Fanout>& tree)
+{
+  tree.assign(values.begin(), values.end(), [](const T& value) { return keyOf(value); });
+}
+
+
+// Look up the key of every value in [first, last), 'Width' lookups at a time. A lane
+// that is done starts on the next key right away. 'visit' gets what each lookup
+// found, or nullptr, in the order the lookups finish
+template<size_t Width, typename Container, typename InputIterator, typename Visit>
+void interleavedLookup(const Container& container, InputIterator first, InputIterator last, Visit visit)
+{
+  static_assert(Width > 0, "at least one lookup at a time");
+  LookupCursor<Container> lanes[Width];
+  bool busy[Width];
+  size_t active = 0;
+  for (size_t lane = 0; lane != Width; ++lane)
+  {
+    busy[lane] = (first != last);
+    if (busy[lane])
+    {
+      lanes[lane].start(container, keyOf(*first++));
+      ++active;
+    }
+  }
+  while (active > 0)
+  {
+    for (size_t lane = 0; lane != Width; ++lane)
+    {
+      if (!busy[lane] || !lanes[lane].step()) {
+        continue;
+      }
+      visit(lanes[lane].found());
+      if (first != last) {
+        lanes[lane].start(container, keyOf(*first++));
+      } else {
+        busy[lane] = false;
+        --active;
+      }
+    }
+  }
+}
+
+#endif // BATCHED_LOOKUP_H_
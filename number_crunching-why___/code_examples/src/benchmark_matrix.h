@@ -0,0 +1,235 @@
+#ifndef BENCHMARK_MATRIX_H_
+#define BENCHMARK_MATRIX_H_
+
+// Compile time expansion of a benchmark matrix: every (workload x POD size x container)
+// combination from three lists becomes one named cell, e.g. "linear_insert/vector/POD<16>".
+// Extending the matrix is done by adding one type (or size) to a list.
+//
+//   typedef TypeList<LinearInsert, LinearErase>     Workloads;
+//   typedef SizeList<1, 4, 16, 64>                  PodSizes;
+//   typedef TypeList<StdList, StdVector, StdDeque>  Containers;
+//   BenchmarkMatrix matrix;
+//   registerMatrix(matrix, Workloads(), PodSizes(), Containers());
+//
+// A container is a selector with a name and an alias template 'Of<T>'. A workload has
+// a name, the element counts to sweep and
+//   template<typename Container, Number Size>
+//   static TimeValue run(size_t nbr_of_elements, const RunContext& context)
+//   template<typename Container, Number Size>
+//   static TimeValue record(size_t nbr_of_elements, const RunContext& context, LatencyHistogram& histogram)
+// where 'run' returns the total time and 'record' puts the latency of every single
+// operation in the histogram (and also returns the total time). A workload that derives
+// from TimedWorkload<Workload> gets both from one
+//   template<typename Container, Number Size, typename Timing>
+//   static TimeValue measure(size_t nbr_of_elements, const RunContext& context, Timing& timing)
+// that sets up the containers and returns timing.each(values, operation) or
+// timing.times(n, operation): 'run' times all operations together, 'record' each of
+// them. The RunContext tells
+// how to set up the measurement, e.g. the cache state before the timed region, and
+// which dataset (dataset.h) to read the input from. A workload can add a short note to
+// its cell with noteCell, e.g. the hit rate it achieved, the runner prints it next to
+// the time.
+// Include "pod_performance.h", "latency_histogram.h", "cache_mode.h", "heap_aging.h" and
+// "dataset.h" before this file.
+// The cells are run by benchmark_runner.h
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <sstream>
+
+
+template<typename... Types> struct TypeList {};
+template<Number... Sizes> struct SizeList {};
+
+
+// How a cell is to be run, set by the runner
+struct RunContext
+{
+  CacheMode cache_mode;
+  HeapState heap_state;       // the runner ages the heap, the workloads need not care
+  HeapAgingConfig heap_aging;
+  DatasetConfig dataset;      // every container reads the same input for the same size
+  std::string* note;          // the note of the cell being measured, nullptr: none is kept
+
+  RunContext() : cache_mode(CacheMode::kAsIs), heap_state(HeapState::kFresh), note(nullptr) {}
+};
+
+// A short note about the cell being measured, printed next to its time
+void noteCell(const RunContext& context, const std::string& note)
+{
+  if (nullptr != context.note) {
+    *context.note = note;
+  }
+}
+
+
+// The timing of 'run': all operations together, no overhead per operation
+class TimeTotal
+{
+public:
+  template<typename Values, typename Operation>
+  TimeValue each(const Values& values, Operation operation)
+  {
+    g2::StopWatch watch;
+    for (auto& value : values) {
+      operation(value);
+    }
+    return watch.elapsedUs().count();
+  }
+
+  template<typename Operation>
+  TimeValue times(const size_t times, Operation operation)
+  {
+    g2::StopWatch watch;
+    for (size_t idx = 0; idx != times; ++idx) {
+      operation();
+    }
+    return watch.elapsedUs().count();
+  }
+};
+
+// The timing of 'record': every operation on its own into the histogram
+class TimeEach
+{
+  LatencyHistogram& histogram_;
+
+public:
+  explicit TimeEach(LatencyHistogram& histogram) : histogram_(histogram) {}
+
+  template<typename Values, typename Operation>
+  TimeValue each(const Values& values, Operation operation)
+  {
+    g2::StopWatch watch;
+    recordEach(values, operation, histogram_);
+    return watch.elapsedUs().count();
+  }
+
+  template<typename Operation>
+  TimeValue times(const size_t times, Operation operation)
+  {
+    g2::StopWatch watch;
+    recordTimes(times, operation, histogram_);
+    return watch.elapsedUs().count();
+  }
+};
+
+// 'run' and 'record' of a workload from its one 'measure'
+template<typename Workload>
+struct TimedWorkload
+{
+  template<typename Container, Number Size>
+  static TimeValue run(const size_t nbr_of_elements, const RunContext& context)
+  {
+    TimeTotal timing;
+    return Workload::template measure<Container, Size>(nbr_of_elements, context, timing);
+  }
+
+  template<typename Container, Number Size>
+  static TimeValue record(const size_t nbr_of_elements, const RunContext& context, LatencyHistogram& histogram)
+  {
+    TimeEach timing(histogram);
+    return Workload::template measure<Container, Size>(nbr_of_elements, context, timing);
+  }
+};
+
+
+struct BenchmarkCell
+{
+  std::string name;     // workload/container/POD<Size>, used for filtering
+  std::string workload;
+  std::string group;    // workload/POD<Size>, cells in the same group are printed side by side
+  std::string column;   // container name
+  std::vector<size_t> sizes;
+  TimeValue (*run)(size_t nbr_of_elements, const RunContext& context);
+  TimeValue (*record)(size_t nbr_of_elements, const RunContext& context, LatencyHistogram& histogram);
+};
+typedef std::vector<BenchmarkCell> BenchmarkMatrix;
+
+
+template<Number Size>
+std::string podName()
+{
+  std::ostringstream oss;
+  oss << "POD<" << Size << ">";
+  return oss.str();
+}
+
+template<typename Workload, Number Size, typename Container>
+BenchmarkCell makeCell()
+{
+  BenchmarkCell cell;
+  cell.workload = Workload::name();
+  cell.group = std::string(Workload::name()) + "/" + podName<Size>();
+  cell.column = Container::name();
+  cell.name = std::string(Workload::name()) + "/" + Container::name() + "/" + podName<Size>();
+  cell.sizes = Workload::sweep();
+  cell.run = &Workload::template run<Container, Size>;
+  cell.record = &Workload::template record<Container, Size>;
+  return cell;
+}
+
+
+// The pack expansions are done inside a braced initializer to force the
+// left to right evaluation order, so that cells are registered in list order
+template<typename Workload, Number Size, typename... Containers>
+void registerContainers(BenchmarkMatrix& matrix, TypeList<Containers...>)
+{
+  int expand[] = {0, (matrix.push_back(makeCell<Workload, Size, Containers>()), 0)...};
+  (void)expand;
+}
+
+template<typename Workload, typename ContainerList, Number... Sizes>
+void registerSizes(BenchmarkMatrix& matrix, SizeList<Sizes...>, ContainerList containers)
+{
+  int expand[] = {0, (registerContainers<Workload, Sizes>(matrix, containers), 0)...};
+  (void)expand;
+}
+
+template<typename SizeList, typename ContainerList, typename... Workloads>
+void registerMatrix(BenchmarkMatrix& matrix, TypeList<Workloads...>, SizeList sizes, ContainerList containers)
+{
+  int expand[] = {0, (registerSizes<Workloads>(matrix, sizes, containers), 0)...};
+  (void)expand;
+}
+
+
+// An empty filter matches everything. Otherwise a comma separated list of
+// substrings where any one of them must be part of the cell name
+bool matchesFilter(const std::string& name, const std::string& filter)
+{
+  if (filter.empty()) {
+    return true;
+  }
+  std::istringstream iss(filter);
+  std::string part;
+  while (std::getline(iss, part, ','))
+  {
+    if (!part.empty() && name.find(part) != std::string::npos) {
+      return true;
+    }
+  }
+  return false;
+}
+
+BenchmarkMatrix filterMatrix(const BenchmarkMatrix& matrix, const std::string& filter)
+{
+  BenchmarkMatrix filtered;
+  for (auto& cell : matrix)
+  {
+    if (matchesFilter(cell.name, filter)) {
+      filtered.push_back(cell);
+    }
+  }
+  return filtered;
+}
+
+void listMatrix(const BenchmarkMatrix& matrix)
+{
+  for (auto& cell : matrix) {
+    std::cout << cell.name << std::endl;
+  }
+}
+
+
+#endif // BENCHMARK_MATRIX_H_
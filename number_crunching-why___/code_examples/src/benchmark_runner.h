@@ -0,0 +1,601 @@
+#ifndef BENCHMARK_RUNNER_H_
+#define BENCHMARK_RUNNER_H_
+
+// Command line driven runner for the benchmark matrix (benchmark_matrix.h).
+//
+//   --scenarios=a,b     only these workloads, e.g. linear_insert,sort
+//   --containers=a,b    only these containers, e.g. list,vector
+//   --sizes=a,b,c       run exactly these element counts
+//   --sizes=min:max     run the workloads' own sweep, limited to [min, max]
+//   --reps=N            repeat every measurement N times and report the median
+//   --budget-ms=N       time budget per measurement. A cell is skipped ('-') from the size
+//                       where it is predicted to exceed the budget. The prediction
+//                       extrapolates the growth seen at the earlier sizes of that cell
+//   --cache=a,b         cache state before each timed region: as-is (default), warm, cold
+//                       and/or clflush. Every mode gets its own table, see cache_mode.h
+//   --heap=a,b          fresh (default) and/or aged. For aged a random malloc/free churn of
+//                       mixed sizes is run before each measurement, see heap_aging.h
+//   --heap-churn=N      number of malloc/free calls of the churn (default 1000000)
+//   --heap-live=N       most allocations alive during the churn (default 100000), they
+//                       stay alive during the measurement
+//   --datasets=dir      where the input datasets are kept (default ./datasets), they are
+//                       generated the first time and then mmap'ed, see dataset.h
+//   --input=a,b         key distribution of the input: uniform (default), ascending,
+//                       descending, nearly_sorted and/or runs. Every input gets its own
+//                       table, see dataset.h
+//   --seed=N            seed of the input (default 2012). The same seed gives the same input
+//   --swaps=k           k swaps of two random positions for the nearly_sorted input
+//                       (default count/100, at least one), e.g. 0 or 10. With k the input
+//                       is named nearly_sorted_k<k> in the tables and the baselines
+//   --save-baseline=f   write every measured cell, with the time of each repetition, to f
+//   --baseline=f        compare every cell that is also in the baseline f and exit with 2
+//                       when one of them regressed, or was not measured this time
+//                       (timeout, failed, skipped over the budget), see baseline.h
+//   --threshold=P       a tracked cell regresses when it is more than P% slower (default 10)
+//                       and the difference is significant
+//   --histogram         time every single operation and report the p50, p99, p99.9
+//                       and max latency in nanoseconds instead of the total time
+//   --isolate           run every measurement (all its repetitions) in a forked child
+//                       process, so that no cell inherits the heap, page mappings or RSS
+//                       of the cells before it, see fork_isolation.h. POSIX only
+//   --timeout-ms=N      kill an isolated measurement that takes longer than N ms and
+//                       report it as 'timeout'. Implies --isolate
+//   --list              only print the names of the selected cells
+//   --help              print the usage
+//   anything else       substring filter on the cell names, see matchesFilter
+//
+// Include "g2_chrono.h", "latency_histogram.h", "cache_mode.h", "heap_aging.h",
+// "dataset.h", "fork_isolation.h", "baseline.h", "memory_probe.h" and "benchmark_matrix.h"
+// before this file.
+
+#include <string>
+#include <vector>
+#include <limits>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+
+struct RunnerOptions
+{
+  std::string filter;
+  std::vector<std::string> scenarios;
+  std::vector<std::string> containers;
+  std::vector<size_t> sizes;
+  size_t min_elements;
+  size_t max_elements;
+  std::vector<CacheMode> cache_modes;
+  std::vector<HeapState> heap_states;
+  std::vector<Distribution> inputs;
+  HeapAgingConfig heap_aging;
+  DatasetConfig dataset;
+  size_t repetitions;
+  long long budget_ms;
+  long long timeout_ms;
+  bool isolate;
+  std::string baseline;
+  std::string save_baseline;
+  double threshold_percent;
+  bool histogram;
+  bool list_only;
+  bool help;
+
+  RunnerOptions()
+    : min_elements(0), max_elements(std::numeric_limits<size_t>::max())
+    , cache_modes(1, CacheMode::kAsIs), heap_states(1, HeapState::kFresh), inputs(1, Distribution::kUniform)
+    , repetitions(1), budget_ms(0), timeout_ms(0), isolate(false), threshold_percent(10)
+    , histogram(false), list_only(false), help(false) {}
+};
+
+
+std::vector<std::string> splitList(const std::string& text)
+{
+  std::vector<std::string> items;
+  std::istringstream iss(text);
+  std::string item;
+  while (std::getline(iss, item, ','))
+  {
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+template<typename Value>
+bool parseValue(const std::string& text, Value& value)
+{
+  std::istringstream iss(text);
+  iss >> value;
+  return !iss.fail() && iss.eof();
+}
+
+void printRunnerUsage(const char* program)
+{
+  std::cout << "Usage: " << program << " [--scenarios=a,b] [--containers=a,b] [--sizes=a,b,c | --sizes=min:max]" << std::endl;
+  std::cout << "       [--cache=as-is,warm,cold,clflush] [--heap=fresh,aged] [--heap-churn=N] [--heap-live=N]" << std::endl;
+  std::cout << "       [--datasets=dir] [--input=uniform,ascending,descending,nearly_sorted,runs] [--seed=N]" << std::endl;
+  std::cout << "       [--swaps=k]" << std::endl;
+  std::cout << "       [--reps=N] [--budget-ms=N] [--isolate] [--timeout-ms=N] [--histogram] [--list]" << std::endl;
+  std::cout << "       [--save-baseline=file] [--baseline=file] [--threshold=percent] [filter]" << std::endl;
+  std::cout << "The filter is a comma separated list of substrings of the cell names," << std::endl;
+  std::cout << "use --list to see all cell names" << std::endl;
+}
+
+
+// Returns false, after printing what was wrong, for unknown or malformed arguments
+bool parseRunnerOptions(int argc, char** argv, RunnerOptions& options)
+{
+  for (int idx = 1; idx < argc; ++idx)
+  {
+    const std::string arg = argv[idx];
+    const size_t equal = arg.find('=');
+    const std::string key = arg.substr(0, equal);
+    const std::string value = (equal == std::string::npos) ? "" : arg.substr(equal + 1);
+    bool ok = true;
+
+    if ("--list" == arg) {
+      options.list_only = true;
+    } else if ("--isolate" == arg) {
+      options.isolate = true;
+    } else if ("--histogram" == arg) {
+      options.histogram = true;
+    } else if ("--help" == arg || "-h" == arg) {
+      options.help = true;
+    } else if ("--scenarios" == key) {
+      options.scenarios = splitList(value);
+    } else if ("--containers" == key) {
+      options.containers = splitList(value);
+    } else if ("--cache" == key) {
+      options.cache_modes.clear();
+      for (auto& item : splitList(value))
+      {
+        CacheMode mode;
+        ok = ok && parseCacheMode(item, mode);
+        options.cache_modes.push_back(mode);
+      }
+      ok = ok && !options.cache_modes.empty();
+    } else if ("--heap" == key) {
+      options.heap_states.clear();
+      for (auto& item : splitList(value))
+      {
+        HeapState state;
+        ok = ok && parseHeapState(item, state);
+        options.heap_states.push_back(state);
+      }
+      ok = ok && !options.heap_states.empty();
+    } else if ("--heap-churn" == key) {
+      ok = parseValue(value, options.heap_aging.operations);
+    } else if ("--heap-live" == key) {
+      ok = parseValue(value, options.heap_aging.max_live) && options.heap_aging.max_live > 0;
+    } else if ("--datasets" == key) {
+      options.dataset.directory = value;
+      ok = !value.empty();
+    } else if ("--input" == key) {
+      options.inputs.clear();
+      for (auto& item : splitList(value))
+      {
+        Distribution distribution;
+        ok = ok && parseDistribution(item, distribution);
+        options.inputs.push_back(distribution);
+      }
+      ok = ok && !options.inputs.empty();
+    } else if ("--seed" == key) {
+      ok = parseValue(value, options.dataset.seed);
+    } else if ("--swaps" == key) {
+      ok = parseValue(value, options.dataset.swaps) && kOnePercentSwaps != options.dataset.swaps;
+    } else if ("--baseline" == key) {
+      options.baseline = value;
+      ok = !value.empty();
+    } else if ("--save-baseline" == key) {
+      options.save_baseline = value;
+      ok = !value.empty();
+    } else if ("--threshold" == key) {
+      ok = parseValue(value, options.threshold_percent) && options.threshold_percent >= 0;
+    } else if ("--reps" == key) {
+      ok = parseValue(value, options.repetitions) && options.repetitions > 0;
+    } else if ("--budget-ms" == key) {
+      ok = parseValue(value, options.budget_ms) && options.budget_ms >= 0;
+    } else if ("--timeout-ms" == key) {
+      ok = parseValue(value, options.timeout_ms) && options.timeout_ms > 0;
+      options.isolate = true;
+    } else if ("--sizes" == key) {
+      const size_t colon = value.find(':');
+      if (colon != std::string::npos) {
+        ok = parseValue(value.substr(0, colon), options.min_elements)
+          && parseValue(value.substr(colon + 1), options.max_elements);
+      } else {
+        for (auto& item : splitList(value))
+        {
+          size_t nbr_of_elements = 0;
+          ok = ok && parseValue(item, nbr_of_elements);
+          options.sizes.push_back(nbr_of_elements);
+        }
+        std::sort(options.sizes.begin(), options.sizes.end());
+        ok = ok && !options.sizes.empty();
+      }
+    } else if (0 != arg.compare(0, 2, "--")) {
+      options.filter = arg;
+    } else {
+      ok = false;
+    }
+
+    if (!ok) {
+      std::cout << "Bad argument: " << arg << std::endl;
+      printRunnerUsage(argv[0]);
+      return false;
+    }
+  }
+  if (options.isolate && !isolationSupported()) {
+    std::cout << "--isolate and --timeout-ms need fork(), they are not supported on this system" << std::endl;
+    return false;
+  }
+  if (options.help) {
+    printRunnerUsage(argv[0]);
+  }
+  return true;
+}
+
+
+
+bool selected(const std::vector<std::string>& wanted, const std::string& name)
+{
+  return wanted.empty() || wanted.end() != std::find(wanted.begin(), wanted.end(), name);
+}
+
+BenchmarkMatrix selectCells(const BenchmarkMatrix& matrix, const RunnerOptions& options)
+{
+  BenchmarkMatrix cells;
+  for (auto& cell : filterMatrix(matrix, options.filter))
+  {
+    if (selected(options.scenarios, cell.workload) && selected(options.containers, cell.column)) {
+      cells.push_back(cell);
+    }
+  }
+  return cells;
+}
+
+std::vector<size_t> selectSizes(const std::vector<size_t>& sweep, const RunnerOptions& options)
+{
+  if (!options.sizes.empty()) {
+    return options.sizes;
+  }
+  std::vector<size_t> sizes;
+  for (auto nbr_of_elements : sweep)
+  {
+    if (nbr_of_elements >= options.min_elements && nbr_of_elements <= options.max_elements) {
+      sizes.push_back(nbr_of_elements);
+    }
+  }
+  return sizes;
+}
+
+
+struct Measured
+{
+  size_t nbr_of_elements;
+  TimeValue time_us;
+};
+
+// Predict the time for 'nbr_of_elements' from the earlier measurements of the same cell,
+// assuming time ~ n^k. k is taken from the last two measurements and kept within [1, 3],
+// with only one earlier measurement k = 2 is assumed since most cells here are O(n^2)
+double predictTimeUs(const std::vector<Measured>& history, const size_t nbr_of_elements)
+{
+  if (history.empty()) {
+    return 0;
+  }
+  const Measured& last = history.back();
+  double exponent = 2.0;
+  if (history.size() >= 2)
+  {
+    const Measured& previous = history[history.size() - 2];
+    if (previous.time_us > 0 && last.time_us > 0 && last.nbr_of_elements > previous.nbr_of_elements)
+    {
+      exponent = std::log(double(last.time_us) / previous.time_us)
+               / std::log(double(last.nbr_of_elements) / previous.nbr_of_elements);
+      exponent = std::min(3.0, std::max(1.0, exponent));
+    }
+  }
+  const double base = std::max(1.0, double(last.time_us));
+  return base * std::pow(double(nbr_of_elements) / std::max(size_t(1), last.nbr_of_elements), exponent);
+}
+
+// Run 'measure' as it is on a fresh heap, or with an AgedHeap alive around it.
+// Note that "fresh" is the heap as the earlier cells left it. Most of an aged heap's
+// chunks coalesce again when it is freed, but not all of them
+template<typename Measure>
+TimeValue onHeap(const RunContext& context, Measure measure)
+{
+  if (HeapState::kAged != context.heap_state) {
+    return measure();
+  }
+  AgedHeap aged(context.heap_aging);
+  return measure();
+}
+
+// Median of 'repetitions' runs, the time of every run is added to 'times'
+TimeValue runRepeated(const BenchmarkCell& cell, const size_t nbr_of_elements, const RunContext& context,
+                      const size_t repetitions, std::vector<TimeValue>& times)
+{
+  for (size_t rep = 0; rep != repetitions; ++rep) {
+    times.push_back(onHeap(context, [&]() { return cell.run(nbr_of_elements, context); }));
+  }
+  std::vector<TimeValue> sorted(times);
+  std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+  return sorted[sorted.size() / 2];
+}
+
+
+// All 'repetitions' runs are recorded into the same histogram. Returns the mean total time,
+// the total time of every run is added to 'times'
+TimeValue recordRepeated(const BenchmarkCell& cell, const size_t nbr_of_elements, const RunContext& context,
+                         const size_t repetitions, LatencyHistogram& histogram, std::vector<TimeValue>& times)
+{
+  TimeValue total = 0;
+  for (size_t rep = 0; rep != repetitions; ++rep) {
+    times.push_back(onHeap(context, [&]() { return cell.record(nbr_of_elements, context, histogram); }));
+    total += times.back();
+  }
+  return total / TimeValue(repetitions);
+}
+
+// Everything a measurement reports. Trivially copyable, so that an isolated child
+// can send it back to the runner. Only the first kMaxSamples repetitions are kept
+// for the baseline
+struct CellResult
+{
+  static const size_t kMaxSamples = 64;
+
+  static const size_t kMaxNote = 32;
+
+  TimeValue time_us;
+  LatencySummary latency; // only in histogram mode
+  size_t nbr_of_samples;
+  TimeValue samples[kMaxSamples];
+  char note[kMaxNote];    // noteCell of the last run, "" for none
+};
+
+CellResult measureCell(const BenchmarkCell& cell, const size_t nbr_of_elements, const RunContext& context,
+                       const RunnerOptions& options)
+{
+  CellResult result = CellResult();
+  std::vector<TimeValue> times;
+  std::string note;
+  RunContext noted = context;
+  noted.note = &note;
+  if (options.histogram) {
+    LatencyHistogram histogram;
+    result.time_us = recordRepeated(cell, nbr_of_elements, noted, options.repetitions, histogram, times);
+    result.latency = summarize(histogram);
+  } else {
+    result.time_us = runRepeated(cell, nbr_of_elements, noted, options.repetitions, times);
+  }
+  result.nbr_of_samples = std::min(times.size(), CellResult::kMaxSamples);
+  std::copy(times.begin(), times.begin() + result.nbr_of_samples, result.samples);
+  note.copy(result.note, CellResult::kMaxNote - 1);
+  return result;
+}
+
+// In-process, or in a child process with --isolate
+IsolationStatus measureCell(const BenchmarkCell& cell, const size_t nbr_of_elements, const RunContext& context,
+                            const RunnerOptions& options, CellResult& result)
+{
+  if (!options.isolate) {
+    result = measureCell(cell, nbr_of_elements, context, options);
+    return IsolationStatus::kOk;
+  }
+  return runIsolated([&]() { return measureCell(cell, nbr_of_elements, context, options); },
+                     options.timeout_ms, result);
+}
+
+// The histogram counts cycles, they are printed as nanoseconds
+void printLatencies(const LatencySummary& latency)
+{
+  std::cout << "\t" << latency.count << ",\t" << g2::cyclesToNs(latency.p50).count();
+  std::cout << ",\t" << g2::cyclesToNs(latency.p99).count();
+  std::cout << ",\t" << g2::cyclesToNs(latency.p999).count();
+  std::cout << ",\t" << g2::cyclesToNs(latency.max).count();
+}
+
+
+CellSamples cellSamples(const BenchmarkCell& cell, const size_t nbr_of_elements, const RunContext& context,
+                        const std::string& status)
+{
+  CellSamples samples;
+  samples.name = cell.name;
+  samples.cache = cacheModeName(context.cache_mode);
+  samples.heap = heapStateName(context.heap_state);
+  samples.input = inputName(context.dataset);
+  samples.nbr_of_elements = nbr_of_elements;
+  samples.status = status;
+  return samples;
+}
+
+
+// One table for the cells [begin, end) of a group. Every row is one element count and
+// the columns are the containers, i.e. the same table as the hand written measure<>.
+// In histogram mode every container gets its own row with the latency percentiles.
+// Every cell and element count is added to 'results', with its samples when it was
+// measured and otherwise why not ("skipped", "timeout", ...)
+void runGroup(const BenchmarkMatrix& matrix, const size_t begin, const size_t end,
+              const RunnerOptions& options, const RunContext& context, BaselineResults& results)
+{
+  const double budget_us = double(options.budget_ms) * 1000;
+  g2::StopWatch watch;
+  if (options.histogram) {
+    std::cout << "Measuring " << matrix[begin].group << " latency per operation in nanoseconds (ns)";
+  } else {
+    std::cout << "Measuring " << matrix[begin].group << " In Microseconds (us)";
+  }
+  if (context.cache_mode != CacheMode::kAsIs) {
+    std::cout << ", " << cacheModeName(context.cache_mode) << " cache";
+  }
+  if (context.heap_state != HeapState::kFresh) {
+    std::cout << ", " << heapStateName(context.heap_state) << " heap";
+  }
+  if (context.dataset.distribution != Distribution::kUniform) {
+    std::cout << ", " << inputName(context.dataset) << " input";
+  }
+  if (options.repetitions > 1) {
+    std::cout << (options.histogram ? ", all of " : ", median of ") << options.repetitions << " runs";
+  }
+  if (options.isolate) {
+    std::cout << ", isolated";
+  }
+  std::cout << std::endl << "elements      ";
+  if (options.histogram) {
+    std::cout << "\tcontainer\toperations\tp50\tp99\tp99.9\tmax";
+  } else {
+    for (size_t idx = begin; idx != end; ++idx) {
+      std::cout << "\t" << matrix[idx].column;
+    }
+  }
+  std::cout << std::endl;
+
+  std::vector<std::vector<Measured>> history(end - begin);
+  std::vector<bool> over_budget(end - begin, false);
+  for (auto nbr_of_elements : selectSizes(matrix[begin].sizes, options))
+  {
+    if (!options.histogram) {
+      std::cout << nbr_of_elements << ",\t" << std::flush;
+    }
+    for (size_t idx = begin; idx != end; ++idx)
+    {
+      const size_t column = idx - begin;
+      if (budget_us > 0 && !over_budget[column]) {
+        over_budget[column] = predictTimeUs(history[column], nbr_of_elements) * options.repetitions > budget_us;
+      }
+      if (options.histogram) {
+        std::cout << nbr_of_elements << ",\t" << matrix[idx].column << "," << std::flush;
+      }
+      if (over_budget[column]) {
+        std::cout << (options.histogram ? "\t-\n" : "\t-,") << std::flush;
+        results.push_back(cellSamples(matrix[idx], nbr_of_elements, context, "skipped"));
+        continue;
+      }
+
+      CellResult result;
+      const IsolationStatus status = measureCell(matrix[idx], nbr_of_elements, context, options, result);
+      if (IsolationStatus::kOk != status) {
+        // a larger size would not do any better
+        over_budget[column] = true;
+        std::cout << "\t" << isolationStatusName(status) << (options.histogram ? "\n" : ",") << std::flush;
+        results.push_back(cellSamples(matrix[idx], nbr_of_elements, context, isolationStatusName(status)));
+        continue;
+      }
+
+      Measured measured = {nbr_of_elements, result.time_us};
+      if (options.histogram) {
+        printLatencies(result.latency);
+        if ('\0' != result.note[0]) {
+          std::cout << ",\t" << result.note;
+        }
+        std::cout << std::endl;
+      } else {
+        std::cout << "\t" << measured.time_us;
+        if ('\0' != result.note[0]) {
+          std::cout << " (" << result.note << ")";
+        }
+        std::cout << "," << std::flush;
+      }
+      history[column].push_back(measured);
+
+      CellSamples samples = cellSamples(matrix[idx], nbr_of_elements, context, "ok");
+      samples.samples.assign(result.samples, result.samples + result.nbr_of_samples);
+      results.push_back(samples);
+    }
+    if (!options.histogram) {
+      std::cout << std::endl;
+    }
+  }
+  auto total_time_ms = watch.elapsedMs().count();
+  std::cout << "Test finished for " << matrix[begin].group << ", it took " << total_time_ms;
+  std::cout << " milliseconds (or " << total_time_ms/1000 << " seconds)";
+  if (budget_us > 0) {
+    std::cout << "\n'-' means skipped: predicted to take more than " << options.budget_ms << " ms";
+  }
+  if (options.timeout_ms > 0) {
+    std::cout << "\n'timeout' means killed after " << options.timeout_ms << " ms, larger sizes are skipped";
+  }
+  std::cout << "\n\n" << std::endl;
+}
+
+
+// Run the cells group by group, once for every input, heap state and cache mode.
+// Returns every cell that was run or skipped
+// 'memory' is the calibration of the host (probeMemory), printed with the report
+BaselineResults runMatrix(const BenchmarkMatrix& matrix, const RunnerOptions& options, const MemoryProfile& memory)
+{
+  BaselineResults results;
+  g2::cyclesPerNs(); // calibrate the TSC before anything is measured
+  std::cout << "Input:";
+  DatasetConfig dataset = options.dataset;
+  for (auto input : options.inputs)
+  {
+    dataset.distribution = input;
+    std::cout << " " << inputName(dataset);
+  }
+  std::cout << " keys, seed ";
+  std::cout << options.dataset.seed << ", datasets in " << options.dataset.directory << "/" << std::endl;
+  printMemoryProfile(memory, std::cout);
+  std::cout << std::endl;
+  size_t begin = 0;
+  while (begin != matrix.size())
+  {
+    size_t end = begin;
+    while (end != matrix.size() && matrix[end].group == matrix[begin].group) {
+      ++end;
+    }
+    for (auto input : options.inputs)
+    {
+      for (auto state : options.heap_states)
+      {
+        for (auto mode : options.cache_modes)
+        {
+          RunContext context;
+          context.cache_mode = mode;
+          context.heap_state = state;
+          context.heap_aging = options.heap_aging;
+          context.dataset = options.dataset;
+          context.dataset.distribution = input;
+          runGroup(matrix, begin, end, options, context, results);
+        }
+      }
+    }
+    begin = end;
+  }
+  return results;
+}
+
+
+// Save and/or compare the results as the options say. 'baseline' was read before the
+// run, with readBaseline. Returns the exit code of the runner: 0, 1 when the baseline
+// could not be written, 2 on a regression or a missing cell. A saved baseline starts with the 'memory'
+// profile of this host as comment lines
+int finishBaseline(const BaselineResults& results, const BaselineResults& baseline, const RunnerOptions& options,
+                   const MemoryProfile& memory)
+{
+  const double kAlpha = 0.05;
+  int exit_code = 0;
+  if (!options.save_baseline.empty())
+  {
+    std::ostringstream notes;
+    printMemoryProfile(memory, notes, "# ");
+    if (writeBaseline(options.save_baseline, results, notes.str())) {
+      const size_t saved = size_t(std::count_if(results.begin(), results.end(),
+                                                [](const CellSamples& cell) { return cell.measured(); }));
+      std::cout << "Baseline of " << saved << " cells saved to " << options.save_baseline << std::endl;
+    } else {
+      std::cout << "Could not write baseline " << options.save_baseline << std::endl;
+      exit_code = 1;
+    }
+  }
+  if (!options.baseline.empty() && compareWithBaseline(baseline, results, options.threshold_percent, kAlpha) > 0) {
+    exit_code = 2;
+  }
+  return exit_code;
+}
+
+#endif // BENCHMARK_RUNNER_H_
@@ -0,0 +1,299 @@
+#ifndef BLOCK_DEQUE_H_
+#define BLOCK_DEQUE_H_
+
+// Deque with the block size as a template parameter. std::deque has a fixed block
+// size chosen by the library: libstdc++ uses 512 bytes, which is 128 elements of
+// POD<1> but only 2 elements of POD<64>, so a deque of big records is little more than
+// a list of small arrays. BlockDeque<T, BlockBytes> keeps BlockBytes / sizeof(T)
+// elements per block (at least one) so the block can be fitted to the record size.
+//
+// Same layout as std::deque: a map (vector) of pointers to fixed size blocks, the
+// elements are at [start, start + size) of the concatenated blocks. The block that
+// holds end() is always allocated, so end() and the iterators are always valid
+// pointers. The map is re-centered, with free slots at both ends, when one end runs
+// out. Insert and erase in the middle shift the elements towards the nearer end.
+//
+// Only what the linear insert/erase tests need is implemented: random access
+// iterators, insert/erase at an iterator position, push/pop at both ends, size,
+// empty and clear.
+//
+// BlockDequeCapacity<T, Bytes>::value gives the number of elements in a block.
+
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+
+
+template<typename T, size_t Bytes>
+struct BlockDequeCapacity
+{
+  static const size_t value = (Bytes / sizeof(T) > 1) ? Bytes / sizeof(T) : 1;
+};
+
+
+template<typename T, size_t BlockBytes>
+class BlockDeque
+{
+  static const size_t kBlock = BlockDequeCapacity<T, BlockBytes>::value;
+  typedef typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type Slot;
+
+  std::vector<T*> map_;  // nullptr outside the allocated blocks
+  size_t start_;         // position of the first element, counted from map_[0]
+  size_t size_;
+
+  static T* allocateBlock()  { return reinterpret_cast<T*>(new Slot[kBlock]); }
+  static void freeBlock(T* block) { delete [] reinterpret_cast<Slot*>(block); }
+
+  T* slot(size_t position) { return map_[position / kBlock] + position % kBlock; }
+
+  // Move the allocated blocks to the middle of a map with room for 'extra' more blocks
+  // at each end
+  void recenter(size_t extra)
+  {
+    const size_t first = start_ / kBlock;
+    const size_t last = (start_ + size_) / kBlock; // holds end()
+    const size_t used = last - first + 1;
+    std::vector<T*> map(used + 2 * std::max(extra, used), nullptr);
+    const size_t moved_first = (map.size() - used) / 2;
+    std::copy(map_.begin() + first, map_.begin() + last + 1, map.begin() + moved_first);
+    map_.swap(map);
+    start_ = moved_first * kBlock + start_ % kBlock;
+  }
+
+public:
+  template<typename Value>
+  class IteratorOf
+  {
+    friend class BlockDeque;
+    Value* current_;
+    Value* first_;     // of the block
+    T* const* node_;   // in the map
+
+    void setNode(T* const* node)
+    {
+      node_ = node;
+      first_ = *node;
+    }
+
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Value* pointer;
+    typedef Value& reference;
+
+    IteratorOf() : current_(nullptr), first_(nullptr), node_(nullptr) {}
+    IteratorOf(T* const* node, size_t offset) : current_(*node + offset), first_(*node), node_(node) {}
+
+    // iterator to const_iterator
+    template<typename Other>
+    IteratorOf(const IteratorOf<Other>& other) : current_(other.current_), first_(other.first_), node_(other.node_) {}
+
+    Value& operator*() const  { return *current_; }
+    Value* operator->() const { return current_; }
+    Value& operator[](difference_type n) const { return *(*this + n); }
+
+    IteratorOf& operator++()
+    {
+      if (++current_ == first_ + kBlock)
+      {
+        setNode(node_ + 1);
+        current_ = first_;
+      }
+      return *this;
+    }
+
+    IteratorOf& operator--()
+    {
+      if (current_ == first_)
+      {
+        setNode(node_ - 1);
+        current_ = first_ + kBlock;
+      }
+      --current_;
+      return *this;
+    }
+
+    IteratorOf operator++(int) { IteratorOf before(*this); ++(*this); return before; }
+    IteratorOf operator--(int) { IteratorOf before(*this); --(*this); return before; }
+
+    IteratorOf& operator+=(difference_type n)
+    {
+      const difference_type offset = n + (current_ - first_);
+      if (offset >= 0 && offset < difference_type(kBlock))
+      {
+        current_ += n;
+        return *this;
+      }
+      const difference_type block = (offset > 0) ? offset / difference_type(kBlock)
+                                                 : -difference_type((-offset - 1) / kBlock) - 1;
+      setNode(node_ + block);
+      current_ = first_ + (offset - block * difference_type(kBlock));
+      return *this;
+    }
+
+    IteratorOf& operator-=(difference_type n) { return *this += -n; }
+    IteratorOf operator+(difference_type n) const { IteratorOf moved(*this); return moved += n; }
+    IteratorOf operator-(difference_type n) const { IteratorOf moved(*this); return moved -= n; }
+    friend IteratorOf operator+(difference_type n, const IteratorOf& itr) { return itr + n; }
+
+    template<typename Other>
+    difference_type operator-(const IteratorOf<Other>& other) const
+    {
+      return difference_type(kBlock) * (node_ - other.node_) + (current_ - first_) - (other.current_ - other.first_);
+    }
+
+    template<typename Other> bool operator==(const IteratorOf<Other>& other) const { return current_ == other.current_; }
+    template<typename Other> bool operator!=(const IteratorOf<Other>& other) const { return current_ != other.current_; }
+    template<typename Other> bool operator<(const IteratorOf<Other>& other) const  { return (*this - other) < 0; }
+    template<typename Other> bool operator>(const IteratorOf<Other>& other) const  { return (*this - other) > 0; }
+    template<typename Other> bool operator<=(const IteratorOf<Other>& other) const { return (*this - other) <= 0; }
+    template<typename Other> bool operator>=(const IteratorOf<Other>& other) const { return (*this - other) >= 0; }
+
+    template<typename> friend class IteratorOf;
+  };
+
+  typedef T value_type;
+  typedef IteratorOf<T> iterator;
+  typedef IteratorOf<const T> const_iterator;
+
+  BlockDeque() : map_(8, nullptr), start_(4 * kBlock), size_(0)
+  {
+    map_[4] = allocateBlock();
+  }
+
+  template<typename InputIterator>
+  BlockDeque(InputIterator first, InputIterator last) : map_(8, nullptr), start_(4 * kBlock), size_(0)
+  {
+    map_[4] = allocateBlock();
+    for (; first != last; ++first) {
+      push_back(*first);
+    }
+  }
+
+  ~BlockDeque()
+  {
+    clear();
+    freeBlock(map_[start_ / kBlock]);
+  }
+
+  BlockDeque(const BlockDeque&) = delete;
+  BlockDeque& operator=(const BlockDeque&) = delete;
+
+  iterator begin() { return iterator(&map_[start_ / kBlock], start_ % kBlock); }
+  iterator end()   { return iterator(&map_[(start_ + size_) / kBlock], (start_ + size_) % kBlock); }
+  const_iterator begin() const { return const_cast<BlockDeque*>(this)->begin(); }
+  const_iterator end() const   { return const_cast<BlockDeque*>(this)->end(); }
+
+  size_t size() const { return size_; }
+  bool empty() const  { return 0 == size_; }
+
+  T& operator[](size_t index)             { return *slot(start_ + index); }
+  const T& operator[](size_t index) const { return *const_cast<BlockDeque*>(this)->slot(start_ + index); }
+  T& front() { return (*this)[0]; }
+  T& back()  { return (*this)[size_ - 1]; }
+
+  void clear()
+  {
+    while (!empty()) {
+      pop_back();
+    }
+  }
+
+  void push_back(const T& value)
+  {
+    const size_t end = start_ + size_ + 1;
+    if (0 == end % kBlock && end / kBlock == map_.size()) { // end() moves on past the map
+      recenter(map_.size() / 2);
+    }
+    new (slot(start_ + size_)) T(value);
+    ++size_;
+    if (0 == (start_ + size_) % kBlock) {
+      map_[(start_ + size_) / kBlock] = allocateBlock();
+    }
+  }
+
+  void push_front(const T& value)
+  {
+    if (0 == start_ % kBlock)
+    {
+      if (0 == start_) {
+        recenter(map_.size() / 2);
+      }
+      map_[start_ / kBlock - 1] = allocateBlock();
+    }
+    new (slot(start_ - 1)) T(value);
+    --start_;
+    ++size_;
+  }
+
+  void pop_back()
+  {
+    const size_t end_block = (start_ + size_) / kBlock;
+    --size_;
+    slot(start_ + size_)->~T();
+    if ((start_ + size_) / kBlock != end_block)
+    {
+      freeBlock(map_[end_block]);
+      map_[end_block] = nullptr;
+    }
+  }
+
+  void pop_front()
+  {
+    slot(start_)->~T();
+    ++start_;
+    --size_;
+    if (0 == start_ % kBlock)
+    {
+      freeBlock(map_[start_ / kBlock - 1]);
+      map_[start_ / kBlock - 1] = nullptr;
+    }
+  }
+
+  // Insert before 'position', returns the position of the inserted element
+  iterator insert(const_iterator position, const T& value)
+  {
+    const size_t index = position - begin();
+    const T copy(value); // 'value' may be an element that is shifted
+    if (index < size_ / 2)
+    {
+      push_front(front());
+      if (index > 0) {
+        std::move(begin() + 2, begin() + index + 1, begin() + 1);
+      }
+    }
+    else
+    {
+      push_back(empty() ? copy : back());
+      if (index + 1 < size_) {
+        std::move_backward(begin() + index, end() - 2, end() - 1);
+      }
+    }
+    iterator inserted = begin() + index;
+    *inserted = copy;
+    return inserted;
+  }
+
+  // Returns the position of the element after the erased one
+  iterator erase(const_iterator position)
+  {
+    const size_t index = position - begin();
+    if (index < size_ / 2)
+    {
+      std::move_backward(begin(), begin() + index, begin() + index + 1);
+      pop_front();
+    }
+    else
+    {
+      std::move(begin() + index + 1, end(), begin() + index);
+      pop_back();
+    }
+    return begin() + index;
+  }
+};
+
+#endif // BLOCK_DEQUE_H_
@@ -0,0 +1,312 @@
+#ifndef CACHE_MODE_H_
+#define CACHE_MODE_H_
+
+// Cache state before a timed region:
+//   as-is    whatever the previous measurement left behind (the default)
+//   warm     the input and the container are traversed once, i.e. pre-loaded in cache.
+//            Every line of every element is read, so is what the iterators read on
+//            the way (the links of a std::list, the block map of a std::deque, the
+//            node headers of the unrolled list and the trees) and the heap memory the
+//            elements own. A container with forEachRange has its ranges read instead
+//   cold     a buffer larger than the last level cache is written and read
+//            so that everything else is evicted
+//   clflush  every cache line of the input and the container is flushed with clflush.
+//            Cheaper than the sweep and it only evicts what the measurement touches.
+//            Falls back to the sweep when clflush is not available, or when a
+//            container keeps memory that clflush cannot reach (see CacheReach)
+//
+// prepareCache(mode, values, container) is called right before the timed region,
+// prepareCache(mode, container) before one that has no input, e.g. an erase.
+
+#include <string>
+#include <vector>
+#include <list>
+#include <cstdint>
+#include <utility>
+#include <type_traits>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#if defined(__unix__)
+#include <unistd.h>
+#endif
+
+
+enum class CacheMode { kAsIs, kWarm, kCold, kClflush };
+
+const char* cacheModeName(CacheMode mode)
+{
+  switch (mode)
+  {
+    case CacheMode::kWarm:    return "warm";
+    case CacheMode::kCold:    return "cold";
+    case CacheMode::kClflush: return "clflush";
+    default:                  return "as-is";
+  }
+}
+
+// Returns false for an unknown name
+bool parseCacheMode(const std::string& name, CacheMode& mode)
+{
+  const CacheMode modes[] = {CacheMode::kAsIs, CacheMode::kWarm, CacheMode::kCold, CacheMode::kClflush};
+  for (auto candidate : modes)
+  {
+    if (name == cacheModeName(candidate)) {
+      mode = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+
+const size_t kCacheLineSize = 64;
+
+// Last level cache size if the system tells, else a generous 32MB guess
+size_t lastLevelCacheSize()
+{
+  long size = 0;
+#if defined(_SC_LEVEL3_CACHE_SIZE)
+  size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+  if (size <= 0) {
+    size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  }
+#endif
+  return (size > 0) ? size_t(size) : size_t(32) << 20;
+}
+
+// Write and read a buffer of 4x the last level cache, line by line
+void sweepCaches()
+{
+  static std::vector<char> sweep(4 * lastLevelCacheSize());
+  static char round = 0;
+  ++round;
+  for (size_t idx = 0; idx < sweep.size(); idx += kCacheLineSize) {
+    sweep[idx] = round;
+  }
+  volatile char sink = 0;
+  for (size_t idx = 0; idx < sweep.size(); idx += kCacheLineSize) {
+    sink = sink + sweep[idx];
+  }
+}
+
+void flushLines(const void* address, size_t bytes)
+{
+  if (0 == bytes) {
+    return;
+  }
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+  const char* begin = static_cast<const char*>(address);
+  for (size_t offset = 0; offset < bytes; offset += kCacheLineSize) {
+    _mm_clflush(begin + offset);
+  }
+  _mm_clflush(begin + bytes - 1);
+#else
+  (void)address; (void)bytes;
+#endif
+}
+
+// Ask for the lines of [address, address + bytes) without waiting for them, the loads
+// that follow find them in the cache if there was enough work in between
+void prefetchLines(const void* address, size_t bytes)
+{
+  const char* begin = static_cast<const char*>(address);
+  for (size_t offset = 0; offset < bytes; offset += kCacheLineSize) {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    _mm_prefetch(begin + offset, _MM_HINT_T0);
+#else
+    __builtin_prefetch(begin + offset);
+#endif
+  }
+}
+
+// Order the flushes before what comes next, i.e. the timed region
+void flushFence()
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+  _mm_mfence();
+#endif
+}
+
+bool hasClflush()
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+  return true;
+#else
+  return false;
+#endif
+}
+
+// Touch every cache line of [address, address + bytes). The sum is only there so
+// that the traversal is not optimized away
+void warmLines(const void* address, size_t bytes)
+{
+  if (0 == bytes) {
+    return;
+  }
+  volatile char sink = 0;
+  const char* begin = static_cast<const char*>(address);
+  for (size_t offset = 0; offset < bytes; offset += kCacheLineSize) {
+    sink = sink + begin[offset];
+  }
+  sink = sink + begin[bytes - 1];
+}
+
+
+// The heap memory an element owns, e.g. the payload of the records of element_types.h,
+// visited as (address, bytes). Overloaded next to such an element type and found by
+// argument dependent lookup. Plain elements own nothing
+template<typename Element, typename Visit>
+void forEachOwnedBlock(const Element&, Visit) {}
+
+// What clflush can reach of a container:
+//   OwnRanges    the container visits every range of memory it holds with
+//                forEachRange(visit), visit(address, bytes)
+//   Contiguous   it has data(): one range, e.g. std::vector and the mapped datasets
+//   ListNodes    std::list: every node, the links included. The links, {next, prev},
+//                come right before the element in libstdc++, libc++ and MSVC
+//   OutOfReach   anything else. It keeps memory that its iterators do not show, e.g.
+//                the block map of std::deque, the buckets of std::unordered_map, the
+//                node headers of std::map, the unrolled list and the trees. The
+//                clflush mode sweeps the caches instead
+// The heap memory the elements own (forEachOwnedBlock) is flushed as well.
+struct OwnRanges {};
+struct Contiguous {};
+struct ListNodes {};
+struct OutOfReach {};
+
+template<unsigned Priority> struct ReachPriority : ReachPriority<Priority - 1> {};
+template<> struct ReachPriority<0> {};
+
+void ignoreRange(const void*, size_t) {}
+
+template<typename Container>
+auto cacheReach(const Container& container, ReachPriority<2>) -> decltype(container.forEachRange(ignoreRange), OwnRanges());
+template<typename Container>
+auto cacheReach(const Container& container, ReachPriority<1>) -> decltype(container.data(), Contiguous());
+template<typename T, typename Allocator>
+ListNodes cacheReach(const std::list<T, Allocator>& list, ReachPriority<1>);
+template<typename Container>
+OutOfReach cacheReach(const Container& container, ReachPriority<0>);
+
+template<typename Container>
+struct CacheReach
+{
+  typedef decltype(cacheReach(std::declval<const Container&>(), ReachPriority<2>())) type;
+};
+
+template<typename Container>
+bool flushReaches(const Container&)
+{
+  return !std::is_same<typename CacheReach<Container>::type, OutOfReach>::value;
+}
+
+template<typename T>
+size_t listLinkBytes()
+{
+  const size_t links = 2 * sizeof(void*);
+  return (links + alignof(T) - 1) / alignof(T) * alignof(T);
+}
+
+template<typename Container>
+void flushOwned(const Container& container)
+{
+  for (auto& element : container) {
+    forEachOwnedBlock(element, flushLines);
+  }
+}
+
+template<typename Container>
+void flushContainer(const Container& container, OwnRanges)
+{
+  container.forEachRange(flushLines);
+}
+
+template<typename Container>
+void flushContainer(const Container& container, Contiguous)
+{
+  flushLines(container.data(), container.size() * sizeof(*container.data()));
+  flushOwned(container);
+}
+
+template<typename T, typename Allocator>
+void flushContainer(const std::list<T, Allocator>& list, ListNodes)
+{
+  const size_t links = listLinkBytes<T>();
+  for (auto& element : list) {
+    flushLines(reinterpret_cast<const char*>(&element) - links, links + sizeof(element));
+  }
+  flushOwned(list);
+}
+
+// Not called, prepareCache sweeps instead
+template<typename Container>
+void flushContainer(const Container&, OutOfReach) {}
+
+// Only for a container that flushReaches
+template<typename Container>
+void flushContainer(const Container& container)
+{
+  flushContainer(container, typename CacheReach<Container>::type());
+}
+
+
+template<typename Container>
+void warmContainer(const Container& container, OwnRanges)
+{
+  container.forEachRange(warmLines);
+}
+
+template<typename Container, typename Reach>
+void warmContainer(const Container& container, Reach)
+{
+  for (auto& element : container)
+  {
+    warmLines(&element, sizeof(element));
+    forEachOwnedBlock(element, warmLines);
+  }
+}
+
+// Touch every cache line of every element, see the warm mode above
+template<typename Container>
+void warmContainer(const Container& container)
+{
+  warmContainer(container, typename CacheReach<Container>::type());
+}
+
+
+template<typename Values, typename Container>
+void prepareCache(CacheMode mode, const Values& values, const Container& container)
+{
+  switch (mode)
+  {
+    case CacheMode::kWarm:
+      warmContainer(values);
+      warmContainer(container);
+      break;
+    case CacheMode::kCold:
+      sweepCaches();
+      break;
+    case CacheMode::kClflush:
+      if (!hasClflush() || !flushReaches(values) || !flushReaches(container)) {
+        sweepCaches();
+        break;
+      }
+      flushContainer(values);
+      flushContainer(container);
+      flushFence();
+      break;
+    default:
+      break;
+  }
+}
+
+template<typename Container>
+void prepareCache(CacheMode mode, const Container& container)
+{
+  prepareCache(mode, std::vector<char>(), container);
+}
+
+#endif // CACHE_MODE_H_
@@ -0,0 +1,326 @@
+#ifndef CONCURRENT_READERS_H_
+#define CONCURRENT_READERS_H_
+
+// Readers that search while one writer inserts and erases. A sorted set of numbers is
+// shared by N reader threads, that look up random keys as fast as they can, and one
+// writer thread that inserts a random key and erases at a random position, in turn,
+// as fast as it can. Every reader times every lookup, the writer counts its updates.
+//
+//   LockedList       std::list behind a std::mutex. A lookup is a walk of the list,
+//                    readers and the writer all take turns, one at a time
+//   RwLockedVector   std::vector behind a reader-writer lock (ReadWriteLock). Readers
+//                    share the lock and binary search, the writer's insert or erase
+//                    moves the tail while every reader waits
+//   SnapshotVector   RCU style copy-on-write. Readers binary search the current
+//                    snapshot, an atomic pointer, and never wait. The writer copies
+//                    the snapshot, updates the copy and publishes it. An old snapshot
+//                    is deleted once no reader can still be in it (epochs, see below)
+//
+// Every set has assign(sorted) before the threads start, contains(key, reader) for
+// reader number 'reader' and, for the one writer only, insert(key) and eraseAt(position).
+// Include "g2_chrono.h", "pod_performance.h" (Number) and "latency_histogram.h" before
+// this file.
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <random>
+#include <memory>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#define READ_WRITE_LOCK_PTHREAD 1
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX // keep std::min and std::max
+#endif
+#include <windows.h>
+#endif
+
+
+// C++11 has no shared mutex: pthread_rwlock_t, or an SRWLOCK on Windows
+class ReadWriteLock
+{
+#if defined(READ_WRITE_LOCK_PTHREAD)
+  pthread_rwlock_t lock_;
+public:
+  ReadWriteLock()  { pthread_rwlock_init(&lock_, nullptr); }
+  ~ReadWriteLock() { pthread_rwlock_destroy(&lock_); }
+  void lockShared()   { pthread_rwlock_rdlock(&lock_); }
+  void unlockShared() { pthread_rwlock_unlock(&lock_); }
+  void lock()         { pthread_rwlock_wrlock(&lock_); }
+  void unlock()       { pthread_rwlock_unlock(&lock_); }
+#else
+  SRWLOCK lock_;
+public:
+  ReadWriteLock()  { InitializeSRWLock(&lock_); }
+  void lockShared()   { AcquireSRWLockShared(&lock_); }
+  void unlockShared() { ReleaseSRWLockShared(&lock_); }
+  void lock()         { AcquireSRWLockExclusive(&lock_); }
+  void unlock()       { ReleaseSRWLockExclusive(&lock_); }
+#endif
+
+  ReadWriteLock(const ReadWriteLock&) = delete;
+  ReadWriteLock& operator=(const ReadWriteLock&) = delete;
+};
+
+class SharedLockGuard
+{
+  ReadWriteLock& lock_;
+public:
+  explicit SharedLockGuard(ReadWriteLock& lock) : lock_(lock) { lock_.lockShared(); }
+  ~SharedLockGuard() { lock_.unlockShared(); }
+
+  SharedLockGuard(const SharedLockGuard&) = delete;
+  SharedLockGuard& operator=(const SharedLockGuard&) = delete;
+};
+
+
+class LockedList
+{
+  mutable std::mutex mutex_;
+  std::list<Number> list_;
+
+public:
+  explicit LockedList(size_t /*nbr_of_readers*/) {}
+
+  void assign(const std::vector<Number>& sorted) { list_.assign(sorted.begin(), sorted.end()); }
+
+  bool contains(const Number key, size_t /*reader*/) const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto itr = std::find_if(list_.begin(), list_.end(), [&](const Number n) { return n >= key; });
+    return itr != list_.end() && *itr == key;
+  }
+
+  void insert(const Number key)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto itr = std::find_if(list_.begin(), list_.end(), [&](const Number n) { return n >= key; });
+    list_.insert(itr, key);
+  }
+
+  void eraseAt(const size_t position)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    list_.erase(std::next(list_.begin(), position));
+  }
+};
+
+
+class RwLockedVector
+{
+  mutable ReadWriteLock lock_;
+  std::vector<Number> vector_;
+
+public:
+  explicit RwLockedVector(size_t /*nbr_of_readers*/) {}
+
+  void assign(const std::vector<Number>& sorted) { vector_ = sorted; }
+
+  bool contains(const Number key, size_t /*reader*/) const
+  {
+    SharedLockGuard lock(lock_);
+    return std::binary_search(vector_.begin(), vector_.end(), key);
+  }
+
+  void insert(const Number key)
+  {
+    std::lock_guard<ReadWriteLock> lock(lock_);
+    vector_.insert(std::lower_bound(vector_.begin(), vector_.end(), key), key);
+  }
+
+  void eraseAt(const size_t position)
+  {
+    std::lock_guard<ReadWriteLock> lock(lock_);
+    vector_.erase(vector_.begin() + position);
+  }
+};
+
+
+// Reclamation with epochs. The epoch counts the published snapshots. A reader stores
+// the epoch in its slot before it loads the snapshot pointer and 0 when it is done.
+// The snapshot that publishing epoch t replaced is deleted when every busy reader
+// announced t or later: such a reader loaded the pointer after it was replaced. All
+// atomics are sequentially consistent. Only one writer
+class SnapshotVector
+{
+  typedef std::vector<Number> Snapshot;
+
+  struct ReaderSlot
+  {
+    std::atomic<uint64_t> epoch;     // 0 when not reading
+    char padding[64 - sizeof(std::atomic<uint64_t>)]; // one cache line per reader
+    ReaderSlot() : epoch(0) {}
+  };
+
+  std::atomic<const Snapshot*> current_;
+  std::atomic<uint64_t> epoch_;
+  std::unique_ptr<ReaderSlot[]> readers_;
+  size_t nbr_of_readers_;
+  std::vector<std::pair<uint64_t, const Snapshot*>> retired_;  // writer only
+
+  void publish(const Snapshot* next)
+  {
+    const Snapshot* old = current_.exchange(next);
+    retired_.push_back(std::make_pair(epoch_.fetch_add(1) + 1, old));
+
+    uint64_t oldest = UINT64_MAX;
+    for (size_t reader = 0; reader != nbr_of_readers_; ++reader)
+    {
+      const uint64_t epoch = readers_[reader].epoch.load();
+      if (0 != epoch) {
+        oldest = std::min(oldest, epoch);
+      }
+    }
+    auto last = std::partition(retired_.begin(), retired_.end(),
+                               [&](const std::pair<uint64_t, const Snapshot*>& retired) { return retired.first > oldest; });
+    for (auto itr = last; itr != retired_.end(); ++itr) {
+      delete itr->second;
+    }
+    retired_.erase(last, retired_.end());
+  }
+
+public:
+  explicit SnapshotVector(size_t nbr_of_readers)
+    : current_(new Snapshot), epoch_(1), readers_(new ReaderSlot[nbr_of_readers])
+    , nbr_of_readers_(nbr_of_readers) {}
+
+  ~SnapshotVector()
+  {
+    delete current_.load();
+    for (auto& retired : retired_) {
+      delete retired.second;
+    }
+  }
+
+  SnapshotVector(const SnapshotVector&) = delete;
+  SnapshotVector& operator=(const SnapshotVector&) = delete;
+
+  void assign(const std::vector<Number>& sorted) { publish(new Snapshot(sorted)); }
+
+  bool contains(const Number key, size_t reader) const
+  {
+    std::atomic<uint64_t>& announced = readers_[reader].epoch;
+    announced.store(epoch_.load());
+    const Snapshot* snapshot = current_.load();
+    const bool found = std::binary_search(snapshot->begin(), snapshot->end(), key);
+    announced.store(0);
+    return found;
+  }
+
+  void insert(const Number key)
+  {
+    Snapshot* next = new Snapshot(*current_.load());
+    next->insert(std::lower_bound(next->begin(), next->end(), key), key);
+    publish(next);
+  }
+
+  void eraseAt(const size_t position)
+  {
+    Snapshot* next = new Snapshot(*current_.load());
+    next->erase(next->begin() + position);
+    publish(next);
+  }
+};
+
+
+struct ConcurrentResult
+{
+  LatencyHistogram reads;   // cycles per lookup, all readers
+  uint64_t writes;
+  TimeValue elapsed_us;
+};
+
+// 'nbr_of_elements' random keys within [0, 2*nbr_of_elements), sorted
+std::vector<Number> sortedRandomKeys(const size_t nbr_of_elements, const uint64_t seed)
+{
+  std::mt19937 engine(static_cast<std::mt19937::result_type>(seed));
+  std::uniform_int_distribution<Number> key(0, Number(2 * nbr_of_elements - 1));
+  std::vector<Number> keys(nbr_of_elements);
+  for (auto& n : keys) {
+    n = key(engine);
+  }
+  std::sort(keys.begin(), keys.end());
+  return keys;
+}
+
+// Run the readers and the writer on 'sorted', not empty, for 'run_ms' milliseconds. The
+// writer inserts before it erases, the size stays within [sorted.size(), sorted.size() + 1]
+template<typename SharedSet>
+ConcurrentResult concurrentReadersPerformance(const std::vector<Number>& sorted, const size_t nbr_of_readers,
+                                              const long long run_ms, const uint64_t seed)
+{
+  SharedSet set(nbr_of_readers);
+  set.assign(sorted);
+  const Number largest_key = Number(2 * sorted.size() - 1);
+  std::atomic<bool> start(false);
+  std::atomic<bool> stop(false);
+  std::mutex merge;
+  ConcurrentResult result;
+  result.writes = 0;
+
+  std::vector<std::thread> readers;
+  for (size_t reader = 0; reader != nbr_of_readers; ++reader)
+  {
+    readers.push_back(std::thread([&, reader]() {
+      std::mt19937 engine(static_cast<std::mt19937::result_type>(seed + reader + 1));
+      std::uniform_int_distribution<Number> key(0, largest_key);
+      LatencyHistogram latencies; // per thread, merged at the end
+      size_t found = 0;
+      while (!start.load()) {
+        std::this_thread::yield();
+      }
+      while (!stop.load(std::memory_order_relaxed))
+      {
+        const Number searched = key(engine);
+        const g2::cycle_count begin = g2::cycles();
+        found += set.contains(searched, reader);
+        latencies.record(g2::cycles() - begin);
+      }
+      volatile size_t sink = found; // keeps the lookups from being optimized away
+      (void)sink;
+      std::lock_guard<std::mutex> lock(merge);
+      result.reads.merge(latencies);
+    }));
+  }
+
+  std::thread writer([&]() {
+    std::mt19937 engine(static_cast<std::mt19937::result_type>(seed));
+    std::uniform_int_distribution<Number> key(0, largest_key);
+    std::uniform_int_distribution<size_t> position(0, sorted.size() - 1);
+    uint64_t writes = 0;
+    while (!start.load()) {
+      std::this_thread::yield();
+    }
+    while (!stop.load(std::memory_order_relaxed))
+    {
+      if (0 == writes % 2) {
+        set.insert(key(engine));
+      } else {
+        set.eraseAt(position(engine));
+      }
+      ++writes;
+    }
+    result.writes = writes;
+  });
+
+  g2::StopWatch watch;
+  start.store(true);
+  std::this_thread::sleep_for(std::chrono::milliseconds(run_ms));
+  stop.store(true);
+  writer.join();
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  result.elapsed_us = watch.elapsedUs().count();
+  return result;
+}
+
+#endif // CONCURRENT_READERS_H_
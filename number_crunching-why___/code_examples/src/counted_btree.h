@@ -0,0 +1,386 @@
+#ifndef COUNTED_BTREE_H_
+#define COUNTED_BTREE_H_
+
+// Order statistic B+tree: a sequence (not a sorted set) where every inner node knows
+// how many elements each of its children holds. Finding the element at a rank is a
+// walk from the root that skips whole subtrees by their counts, so insertAt(rank) and
+// eraseAt(rank) are O(log n) instead of the O(n) walk or memmove of list and vector.
+//
+// The elements live in leaves of 'LeafCapacity' elements that are chained front to
+// back for iteration, just like the nodes of the unrolled list (unrolled_list.h).
+// An inner node holds up to 'Fanout' children with their counts side by side, so the
+// search within a node is a scan over one or two cache lines of counts.
+//
+// A full node is split in two halves, an append at the very end of the last leaf
+// starts a new leaf instead. On erase an empty node is removed and two neighbours that
+// fit in half a node are merged. Only for trivially copyable types.
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <iterator>
+#include <type_traits>
+
+
+template<typename T, size_t LeafCapacity, size_t Fanout = 16>
+class CountedBTree
+{
+  static_assert(std::is_trivially_copyable<T>::value, "CountedBTree shifts elements with memmove");
+  static_assert(LeafCapacity >= 2 && Fanout >= 4, "nodes must be able to split in two");
+
+  struct Node
+  {
+    bool is_leaf;
+    explicit Node(bool leaf) : is_leaf(leaf) {}
+  };
+
+  struct Leaf : Node
+  {
+    size_t size;
+    Leaf* prev;
+    Leaf* next;
+    typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type slots[LeafCapacity];
+
+    Leaf() : Node(true), size(0), prev(nullptr), next(nullptr) {}
+    T* elements() { return reinterpret_cast<T*>(slots); }
+  };
+
+  // one extra slot: a node may overflow by one child before it is split
+  struct Inner : Node
+  {
+    size_t nbr;
+    size_t counts[Fanout + 1];
+    Node* children[Fanout + 1];
+
+    Inner() : Node(false), nbr(0) {}
+
+    void insertChild(size_t index, Node* child, size_t count)
+    {
+      std::memmove(children + index + 1, children + index, (nbr - index) * sizeof(Node*));
+      std::memmove(counts + index + 1, counts + index, (nbr - index) * sizeof(size_t));
+      children[index] = child;
+      counts[index] = count;
+      ++nbr;
+    }
+
+    void removeChild(size_t index)
+    {
+      std::memmove(children + index, children + index + 1, (nbr - index - 1) * sizeof(Node*));
+      std::memmove(counts + index, counts + index + 1, (nbr - index - 1) * sizeof(size_t));
+      --nbr;
+    }
+  };
+
+  Node* root_;
+  Leaf* first_;
+  size_t size_;
+
+  static size_t countOf(const Node* node)
+  {
+    if (node->is_leaf) {
+      return static_cast<const Leaf*>(node)->size;
+    }
+    const Inner* inner = static_cast<const Inner*>(node);
+    size_t count = 0;
+    for (size_t idx = 0; idx != inner->nbr; ++idx) {
+      count += inner->counts[idx];
+    }
+    return count;
+  }
+
+  Leaf* createLeafAfter(Leaf* leaf)
+  {
+    Leaf* created = new Leaf;
+    created->prev = leaf;
+    created->next = leaf->next;
+    if (nullptr != leaf->next) {
+      leaf->next->prev = created;
+    }
+    leaf->next = created;
+    return created;
+  }
+
+  void unlinkLeaf(Leaf* leaf)
+  {
+    if (nullptr != leaf->prev) {
+      leaf->prev->next = leaf->next;
+    } else {
+      first_ = leaf->next;
+    }
+    if (nullptr != leaf->next) {
+      leaf->next->prev = leaf->prev;
+    }
+  }
+
+  void destroy(Node* node)
+  {
+    if (node->is_leaf) {
+      delete static_cast<Leaf*>(node);
+      return;
+    }
+    Inner* inner = static_cast<Inner*>(node);
+    for (size_t idx = 0; idx != inner->nbr; ++idx) {
+      destroy(inner->children[idx]);
+    }
+    delete inner;
+  }
+
+  // Returns the new right sibling when 'leaf' had to split
+  Leaf* insertInLeaf(Leaf* leaf, size_t rank, const T& value)
+  {
+    Leaf* split = nullptr;
+    if (LeafCapacity == leaf->size)
+    {
+      split = createLeafAfter(leaf);
+      if (rank == leaf->size && nullptr == split->next)
+      {
+        // appending at the very end: keep the full leaf full
+        leaf = split;
+        rank = 0;
+      }
+      else
+      {
+        const size_t half = LeafCapacity / 2;
+        std::memcpy(split->elements(), leaf->elements() + half, (LeafCapacity - half) * sizeof(T));
+        split->size = LeafCapacity - half;
+        leaf->size = half;
+        if (rank > half) {
+          leaf = split;
+          rank -= half;
+        }
+      }
+    }
+    T* elements = leaf->elements();
+    std::memmove(elements + rank + 1, elements + rank, (leaf->size - rank) * sizeof(T));
+    new (elements + rank) T(value);
+    ++leaf->size;
+    return split;
+  }
+
+  Inner* splitInner(Inner* inner)
+  {
+    Inner* split = new Inner;
+    const size_t half = inner->nbr / 2;
+    split->nbr = inner->nbr - half;
+    std::memcpy(split->children, inner->children + half, split->nbr * sizeof(Node*));
+    std::memcpy(split->counts, inner->counts + half, split->nbr * sizeof(size_t));
+    inner->nbr = half;
+    return split;
+  }
+
+  // Returns the new right sibling when 'node' had to split
+  Node* insertAt(Node* node, size_t rank, const T& value)
+  {
+    if (node->is_leaf) {
+      return insertInLeaf(static_cast<Leaf*>(node), rank, value);
+    }
+    Inner* inner = static_cast<Inner*>(node);
+    size_t child = 0;
+    while (child + 1 < inner->nbr && rank > inner->counts[child])
+    {
+      rank -= inner->counts[child];
+      ++child;
+    }
+    Node* split = insertAt(inner->children[child], rank, value);
+    ++inner->counts[child];
+    if (nullptr != split)
+    {
+      const size_t moved = countOf(split);
+      inner->counts[child] -= moved;
+      inner->insertChild(child + 1, split, moved);
+      if (inner->nbr > Fanout) {
+        return splitInner(inner);
+      }
+    }
+    return nullptr;
+  }
+
+  // Merge children 'left' and 'left + 1' of 'inner' when they fit in half a node
+  void mergeIfSmall(Inner* inner, size_t left)
+  {
+    Node* a = inner->children[left];
+    Node* b = inner->children[left + 1];
+    if (a->is_leaf)
+    {
+      Leaf* first = static_cast<Leaf*>(a);
+      Leaf* second = static_cast<Leaf*>(b);
+      if (first->size + second->size > LeafCapacity / 2) {
+        return;
+      }
+      std::memcpy(first->elements() + first->size, second->elements(), second->size * sizeof(T));
+      first->size += second->size;
+      unlinkLeaf(second);
+      delete second;
+    }
+    else
+    {
+      Inner* first = static_cast<Inner*>(a);
+      Inner* second = static_cast<Inner*>(b);
+      if (first->nbr + second->nbr > Fanout / 2) {
+        return;
+      }
+      std::memcpy(first->children + first->nbr, second->children, second->nbr * sizeof(Node*));
+      std::memcpy(first->counts + first->nbr, second->counts, second->nbr * sizeof(size_t));
+      first->nbr += second->nbr;
+      delete second;
+    }
+    inner->counts[left] += inner->counts[left + 1];
+    inner->removeChild(left + 1);
+  }
+
+  void eraseAt(Node* node, size_t rank)
+  {
+    if (node->is_leaf)
+    {
+      Leaf* leaf = static_cast<Leaf*>(node);
+      T* elements = leaf->elements();
+      std::memmove(elements + rank, elements + rank + 1, (leaf->size - rank - 1) * sizeof(T));
+      --leaf->size;
+      return;
+    }
+    Inner* inner = static_cast<Inner*>(node);
+    size_t child = 0;
+    while (rank >= inner->counts[child])
+    {
+      rank -= inner->counts[child];
+      ++child;
+    }
+    eraseAt(inner->children[child], rank);
+    --inner->counts[child];
+
+    if (0 == inner->counts[child])
+    {
+      Node* empty = inner->children[child];
+      if (empty->is_leaf) {
+        unlinkLeaf(static_cast<Leaf*>(empty));
+      }
+      destroy(empty); // an empty inner node has no children left
+      inner->removeChild(child);
+    }
+    else if (child + 1 < inner->nbr)
+    {
+      mergeIfSmall(inner, child);
+    }
+    else if (child > 0)
+    {
+      mergeIfSmall(inner, child - 1);
+    }
+  }
+
+public:
+  template<typename Value>
+  class IteratorOf
+  {
+    friend class CountedBTree;
+    Leaf* leaf_;
+    size_t index_;
+
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Value* pointer;
+    typedef Value& reference;
+
+    IteratorOf(Leaf* leaf = nullptr, size_t index = 0) : leaf_(leaf), index_(index) {}
+
+    Value& operator*() const  { return leaf_->elements()[index_]; }
+    Value* operator->() const { return &leaf_->elements()[index_]; }
+    IteratorOf& operator++()
+    {
+      if (++index_ == leaf_->size) {
+        leaf_ = leaf_->next;
+        index_ = 0;
+      }
+      return *this;
+    }
+    IteratorOf operator++(int) { IteratorOf before(*this); ++(*this); return before; }
+    bool operator==(const IteratorOf& other) const { return leaf_ == other.leaf_ && index_ == other.index_; }
+    bool operator!=(const IteratorOf& other) const { return !(*this == other); }
+  };
+
+  typedef T value_type;
+  typedef IteratorOf<T> iterator;
+  typedef IteratorOf<const T> const_iterator;
+
+  CountedBTree() : root_(nullptr), first_(nullptr), size_(0)
+  {
+    first_ = new Leaf;
+    root_ = first_;
+  }
+
+  template<typename InputIterator>
+  CountedBTree(InputIterator first, InputIterator last) : root_(nullptr), first_(nullptr), size_(0)
+  {
+    first_ = new Leaf;
+    root_ = first_;
+    for (; first != last; ++first) {
+      insertAt(size_, *first);
+    }
+  }
+
+  ~CountedBTree() { destroy(root_); }
+
+  CountedBTree(const CountedBTree&) = delete;
+  CountedBTree& operator=(const CountedBTree&) = delete;
+
+  iterator begin() { return iterator(empty() ? nullptr : first_, 0); }
+  iterator end()   { return iterator(); }
+  const_iterator begin() const { return const_iterator(empty() ? nullptr : first_, 0); }
+  const_iterator end() const   { return const_iterator(); }
+
+  size_t size() const { return size_; }
+  bool empty() const  { return 0 == size_; }
+
+  const T& at(size_t rank) const
+  {
+    const Node* node = root_;
+    while (!node->is_leaf)
+    {
+      const Inner* inner = static_cast<const Inner*>(node);
+      size_t child = 0;
+      while (rank >= inner->counts[child])
+      {
+        rank -= inner->counts[child];
+        ++child;
+      }
+      node = inner->children[child];
+    }
+    return const_cast<Leaf*>(static_cast<const Leaf*>(node))->elements()[rank];
+  }
+
+  // Insert so that 'value' gets 'rank', i.e. before the element now at 'rank'. rank <= size()
+  void insertAt(size_t rank, const T& value)
+  {
+    Node* split = insertAt(root_, rank, value);
+    if (nullptr != split)
+    {
+      Inner* root = new Inner;
+      root->insertChild(0, root_, countOf(root_));
+      root->insertChild(1, split, countOf(split));
+      root_ = root;
+    }
+    ++size_;
+  }
+
+  // Erase the element at 'rank'. rank < size()
+  void eraseAt(size_t rank)
+  {
+    eraseAt(root_, rank);
+    --size_;
+    while (!root_->is_leaf && static_cast<Inner*>(root_)->nbr <= 1)
+    {
+      Inner* old = static_cast<Inner*>(root_);
+      if (0 == old->nbr) {
+        first_ = new Leaf;
+        root_ = first_;
+      } else {
+        root_ = old->children[0];
+      }
+      old->nbr = 0;
+      delete old;
+    }
+  }
+};
+
+#endif // COUNTED_BTREE_H_
@@ -0,0 +1,483 @@
+#ifndef DATASET_H_
+#define DATASET_H_
+
+// Reproducible binary input datasets. A dataset file is a 64 byte header followed by
+// the raw elements:
+//
+//   magic "G2DATA1", count, element size, distribution, seed, swaps, (padding)
+//   count x sizeof(Element) bytes of payload
+//
+// The payload is generated from the seed, so the same (count, distribution, seed, swaps) always
+// gives the same input, on every run and for every container. Once written the file is
+// mmap'ed read-only: every worker, thread or forked child, reads the same pages and
+// nothing is copied. Generating large inputs is only done the first time.
+//
+// An Element is trivially copyable and starts with a 32 bit key, e.g. Number or POD<Size>.
+// Only the key is set, the rest is zero. Keys are within [0, count-1], distributed as
+//
+//   uniform         random, std::mt19937
+//   ascending       0, 1, ..., count-1, i.e. sorted
+//   descending      count-1, ..., 1, 0, i.e. reverse sorted
+//   nearly_sorted   ascending, then k swaps of two random positions. k is
+//                   DatasetConfig::swaps, by default count/100 (at least one). It is in
+//                   the header and the file name, e.g. e64_40000_nearly_sorted_k400_2012
+//   runs            kSortedRuns ascending runs of random keys one after the other, each run
+//                   covers the whole key range, like batches that each arrive sorted
+//
+//   MappedDataset<POD<16>> values;
+//   openDataset(values, DatasetConfig(), 40000);
+//   for (auto& pod : values) { ... }
+//
+// When the directory cannot be written the dataset is generated in memory instead,
+// without mmap on Windows the file is read into memory.
+//
+// randomErasePositions and randomInsertPositions are the positions of the erase and
+// insert workloads, from the same seed as the input.
+
+#include <string>
+#include <vector>
+#include <random>
+#include <fstream>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#define DATASET_MMAP 1
+#elif defined(_WIN32)
+#include <direct.h>
+#include <process.h>
+#endif
+
+
+// New distributions go last, the number is stored in the dataset header
+enum class Distribution { kUniform, kAscending, kDescending, kNearlySorted, kRuns };
+
+const uint64_t kSortedRuns = 16;
+
+const char* distributionName(Distribution distribution)
+{
+  switch (distribution)
+  {
+    case Distribution::kAscending:    return "ascending";
+    case Distribution::kDescending:   return "descending";
+    case Distribution::kNearlySorted: return "nearly_sorted";
+    case Distribution::kRuns:         return "runs";
+    default:                          return "uniform";
+  }
+}
+
+// Returns false for an unknown name
+bool parseDistribution(const std::string& name, Distribution& distribution)
+{
+  const Distribution distributions[] = {Distribution::kUniform, Distribution::kAscending, Distribution::kDescending,
+                                        Distribution::kNearlySorted, Distribution::kRuns};
+  for (auto candidate : distributions)
+  {
+    if (name == distributionName(candidate)) {
+      distribution = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+
+// DatasetConfig::swaps for count/100 swaps, at least one
+const uint64_t kOnePercentSwaps = ~uint64_t(0);
+
+// Where the datasets are kept and how they are generated
+struct DatasetConfig
+{
+  std::string directory;
+  Distribution distribution;
+  uint64_t seed;
+  uint64_t swaps;         // nearly_sorted only
+
+  DatasetConfig() : directory("datasets"), distribution(Distribution::kUniform), seed(2012)
+                  , swaps(kOnePercentSwaps) {}
+};
+
+// The swaps of a dataset of 'count' elements, 0 for any distribution but nearly_sorted
+uint64_t datasetSwaps(const DatasetConfig& config, const uint64_t count)
+{
+  if (Distribution::kNearlySorted != config.distribution) {
+    return 0;
+  }
+  return (kOnePercentSwaps == config.swaps) ? std::max(uint64_t(1), count / 100) : config.swaps;
+}
+
+// The distribution name, with the swaps when they are not the default, e.g.
+// nearly_sorted_k10. Tells the inputs apart in the tables and in the baselines
+std::string inputName(const DatasetConfig& config)
+{
+  std::string name = distributionName(config.distribution);
+  if (Distribution::kNearlySorted == config.distribution && kOnePercentSwaps != config.swaps) {
+    name += "_k" + std::to_string(config.swaps);
+  }
+  return name;
+}
+
+
+// Random positions for emptying a container of 'count' elements one erase at a time:
+// the i:th position is within [0, count - 1 - i]. Seeded, so every container gets the
+// very same sequence, and drawn up front so it is not part of the timing
+std::vector<uint32_t> randomErasePositions(const uint64_t count, const uint64_t seed)
+{
+  std::mt19937 engine(static_cast<std::mt19937::result_type>(seed));
+  std::vector<uint32_t> positions(count);
+  for (uint64_t idx = 0; idx != count; ++idx)
+  {
+    std::uniform_int_distribution<uint32_t> distribution(0, uint32_t(count - 1 - idx));
+    positions[idx] = distribution(engine);
+  }
+  return positions;
+}
+
+// Random positions for filling an empty container one insert at a time: the i:th
+// position is within [0, i]
+std::vector<uint32_t> randomInsertPositions(const uint64_t count, const uint64_t seed)
+{
+  std::mt19937 engine(static_cast<std::mt19937::result_type>(seed));
+  std::vector<uint32_t> positions(count);
+  for (uint64_t idx = 0; idx != count; ++idx)
+  {
+    std::uniform_int_distribution<uint32_t> distribution(0, uint32_t(idx));
+    positions[idx] = distribution(engine);
+  }
+  return positions;
+}
+
+
+struct DatasetHeader
+{
+  char magic[8];
+  uint64_t count;
+  uint32_t element_size;
+  uint32_t distribution;
+  uint64_t seed;
+  uint64_t swaps;
+  char reserved[24];      // the payload starts on a cache line of its own
+};
+static_assert(sizeof(DatasetHeader) == 64, "the file format has a 64 byte header");
+
+const char kDatasetMagic[8] = "G2DATA1";
+
+
+// The keys of 'count' ascending keys after 'nbr_of_swaps' swaps of two random positions,
+// only the swapped positions as (position, key) in position order
+std::vector<std::pair<uint64_t, uint32_t>> randomSwaps(const uint64_t count, const uint64_t nbr_of_swaps,
+                                                       std::mt19937& engine)
+{
+  std::vector<std::pair<uint64_t, uint32_t>> swapped;
+  if (count < 2) {
+    return swapped;
+  }
+  std::uniform_int_distribution<uint32_t> position(0, uint32_t(count - 1));
+  auto keyAt = [&](const uint64_t at) -> uint32_t {
+    auto itr = std::lower_bound(swapped.begin(), swapped.end(), std::make_pair(at, uint32_t(0)));
+    return (itr != swapped.end() && itr->first == at) ? itr->second : uint32_t(at);
+  };
+  auto setKey = [&](const uint64_t at, const uint32_t key) {
+    auto itr = std::lower_bound(swapped.begin(), swapped.end(), std::make_pair(at, uint32_t(0)));
+    if (itr != swapped.end() && itr->first == at) {
+      itr->second = key;
+    } else {
+      swapped.insert(itr, std::make_pair(at, key));
+    }
+  };
+  for (uint64_t swap = 0; swap != nbr_of_swaps; ++swap)
+  {
+    const uint64_t first = position(engine);
+    const uint64_t second = position(engine);
+    const uint32_t first_key = keyAt(first);
+    setKey(first, keyAt(second));
+    setKey(second, first_key);
+  }
+  return swapped;
+}
+
+// Generate the payload in chunks, 'consume(elements, count)' is called for each chunk
+template<typename Element, typename Consume>
+void generateElements(const uint64_t count, const Distribution distribution, const uint64_t seed,
+                      const uint64_t swaps, Consume consume)
+{
+  static_assert(std::is_trivially_copyable<Element>::value, "datasets hold raw bytes");
+  static_assert(sizeof(Element) >= sizeof(uint32_t), "an element starts with a 32 bit key");
+  const uint64_t kChunk = 4096;
+  std::mt19937 engine(static_cast<std::mt19937::result_type>(seed));
+  std::uniform_int_distribution<uint32_t> uniform(0, count > 0 ? uint32_t(count - 1) : 0);
+  std::vector<Element> chunk(size_t(std::min(count, kChunk)));
+  std::vector<std::pair<uint64_t, uint32_t>> swapped;
+  if (Distribution::kNearlySorted == distribution) {
+    swapped = randomSwaps(count, swaps, engine);
+  }
+  auto next_swapped = swapped.begin();
+  const uint64_t run_length = std::max(uint64_t(1), (count + kSortedRuns - 1) / kSortedRuns);
+
+  for (uint64_t done = 0; done < count; done += chunk.size())
+  {
+    const size_t in_chunk = size_t(std::min(uint64_t(chunk.size()), count - done));
+    for (size_t idx = 0; idx != in_chunk; ++idx)
+    {
+      const uint64_t at = done + idx;
+      uint32_t key = 0;
+      switch (distribution)
+      {
+        case Distribution::kAscending:  key = uint32_t(at); break;
+        case Distribution::kDescending: key = uint32_t(count - 1 - at); break;
+        case Distribution::kNearlySorted:
+          key = uint32_t(at);
+          if (next_swapped != swapped.end() && next_swapped->first == at) {
+            key = (next_swapped++)->second;
+          }
+          break;
+        case Distribution::kRuns:
+        {
+          // the j:th key of a run is within [j*count/run_length, (j+1)*count/run_length)
+          const uint64_t in_run = at % run_length;
+          const uint64_t low = in_run * count / run_length;
+          const uint64_t high = (in_run + 1) * count / run_length;
+          key = uint32_t(low) + uniform(engine) % uint32_t(high - low);
+          break;
+        }
+        default:                        key = uniform(engine); break;
+      }
+      std::memset(&chunk[idx], 0, sizeof(Element));
+      std::memcpy(&chunk[idx], &key, sizeof(key));
+    }
+    consume(chunk.data(), in_chunk);
+  }
+}
+
+DatasetHeader makeDatasetHeader(const uint64_t count, const size_t element_size,
+                                const Distribution distribution, const uint64_t seed, const uint64_t swaps)
+{
+  DatasetHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kDatasetMagic, sizeof(header.magic));
+  header.count = count;
+  header.element_size = uint32_t(element_size);
+  header.distribution = uint32_t(distribution);
+  header.seed = seed;
+  header.swaps = swaps;
+  return header;
+}
+
+// e.g. datasets/e64_40000_uniform_2012.g2data or datasets/e64_40000_nearly_sorted_k400_2012.g2data
+std::string datasetPath(const DatasetConfig& config, const size_t element_size, const uint64_t count)
+{
+  std::string distribution = distributionName(config.distribution);
+  if (Distribution::kNearlySorted == config.distribution) {
+    distribution += "_k" + std::to_string(datasetSwaps(config, count));
+  }
+  return config.directory + "/e" + std::to_string(element_size) + "_" + std::to_string(count)
+       + "_" + distribution + "_" + std::to_string(config.seed) + ".g2data";
+}
+
+// Write the dataset to a temporary file that is renamed into place, so that concurrent
+// writers (forked children) never see a half written file
+template<typename Element>
+bool writeDataset(const std::string& path, const uint64_t count, const Distribution distribution, const uint64_t seed,
+                  const uint64_t swaps)
+{
+#if defined(DATASET_MMAP)
+  const std::string temporary = path + ".tmp" + std::to_string(getpid());
+#elif defined(_WIN32)
+  const std::string temporary = path + ".tmp" + std::to_string(_getpid());
+#else
+  const std::string temporary = path + ".tmp";
+#endif
+  {
+    std::ofstream out(temporary.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out) {
+      return false;
+    }
+    const DatasetHeader header = makeDatasetHeader(count, sizeof(Element), distribution, seed, swaps);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    generateElements<Element>(count, distribution, seed, swaps, [&](const Element* elements, size_t in_chunk) {
+      out.write(reinterpret_cast<const char*>(elements), std::streamsize(in_chunk * sizeof(Element)));
+    });
+    if (!out) {
+      std::remove(temporary.c_str());
+      return false;
+    }
+  }
+#if defined(_WIN32)
+  std::remove(path.c_str()); // rename does not replace on Windows
+#endif
+  if (0 != std::rename(temporary.c_str(), path.c_str())) {
+    std::remove(temporary.c_str());
+    return false;
+  }
+  return true;
+}
+
+
+
+// Read-only view of a dataset, mapped from a file or, as a fallback, held in memory
+template<typename Element>
+class MappedDataset
+{
+  const char* base_;      // the header, followed by the payload
+  size_t bytes_;
+  bool mapped_;
+  std::vector<char> owned_;
+
+  void release()
+  {
+#if defined(DATASET_MMAP)
+    if (mapped_) {
+      munmap(const_cast<char*>(base_), bytes_);
+    }
+#endif
+    base_ = nullptr;
+    bytes_ = 0;
+    mapped_ = false;
+    owned_.clear();
+  }
+
+  const DatasetHeader& header() const { return *reinterpret_cast<const DatasetHeader*>(base_); }
+
+public:
+  typedef Element value_type;
+  typedef const Element* const_iterator;
+
+  MappedDataset() : base_(nullptr), bytes_(0), mapped_(false) {}
+  ~MappedDataset() { release(); }
+
+  MappedDataset(const MappedDataset&) = delete;
+  MappedDataset& operator=(const MappedDataset&) = delete;
+
+  // Map 'path'. False if it cannot be read or is not a dataset of 'Element'
+  bool open(const std::string& path)
+  {
+    release();
+#if defined(DATASET_MMAP)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat status;
+    if (0 != fstat(fd, &status) || size_t(status.st_size) < sizeof(DatasetHeader)) {
+      ::close(fd);
+      return false;
+    }
+    int flags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+    flags |= MAP_POPULATE; // fault the pages in now, not inside a timed region
+#endif
+    void* memory = mmap(nullptr, size_t(status.st_size), PROT_READ, flags, fd, 0);
+    ::close(fd); // the mapping keeps the file alive
+    if (MAP_FAILED == memory) {
+      return false;
+    }
+    base_ = static_cast<const char*>(memory);
+    bytes_ = size_t(status.st_size);
+    mapped_ = true;
+#else
+    std::ifstream in(path.c_str(), std::ios::binary);
+    owned_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    if (owned_.size() < sizeof(DatasetHeader)) {
+      owned_.clear();
+      return false;
+    }
+    base_ = owned_.data();
+    bytes_ = owned_.size();
+#endif
+    if (!valid()) {
+      release();
+      return false;
+    }
+    return true;
+  }
+
+  // Generate the dataset in memory, for when it cannot be written to disk
+  void generate(const uint64_t count, const Distribution distribution, const uint64_t seed, const uint64_t swaps)
+  {
+    release();
+    const DatasetHeader header = makeDatasetHeader(count, sizeof(Element), distribution, seed, swaps);
+    owned_.reserve(sizeof(header) + size_t(count) * sizeof(Element));
+    owned_.insert(owned_.end(), reinterpret_cast<const char*>(&header), reinterpret_cast<const char*>(&header + 1));
+    generateElements<Element>(count, distribution, seed, swaps, [&](const Element* elements, size_t in_chunk) {
+      const char* bytes = reinterpret_cast<const char*>(elements);
+      owned_.insert(owned_.end(), bytes, bytes + in_chunk * sizeof(Element));
+    });
+    base_ = owned_.data();
+    bytes_ = owned_.size();
+  }
+
+  bool valid() const
+  {
+    return nullptr != base_ && 0 == std::memcmp(header().magic, kDatasetMagic, sizeof(kDatasetMagic))
+        && sizeof(Element) == header().element_size
+        && bytes_ == sizeof(DatasetHeader) + header().count * sizeof(Element);
+  }
+
+  bool matches(const uint64_t count, const Distribution distribution, const uint64_t seed, const uint64_t swaps) const
+  {
+    return valid() && count == header().count && uint32_t(distribution) == header().distribution
+        && seed == header().seed && swaps == header().swaps;
+  }
+
+  bool isMapped() const { return mapped_; }
+  uint64_t seed() const { return header().seed; }
+  uint64_t swaps() const { return header().swaps; }
+  Distribution distribution() const { return Distribution(header().distribution); }
+
+  size_t size() const   { return nullptr == base_ ? 0 : size_t(header().count); }
+  bool empty() const    { return 0 == size(); }
+  const Element* data() const { return reinterpret_cast<const Element*>(base_ + sizeof(DatasetHeader)); }
+  const_iterator begin() const { return data(); }
+  const_iterator end() const   { return data() + size(); }
+  const Element& operator[](size_t index) const { return data()[index]; }
+};
+
+
+bool makeDirectory(const std::string& directory)
+{
+#if defined(DATASET_MMAP)
+  return 0 == mkdir(directory.c_str(), 0755) || EEXIST == errno;
+#elif defined(_WIN32)
+  return 0 == _mkdir(directory.c_str()) || EEXIST == errno;
+#else
+  (void)directory;
+  return true;
+#endif
+}
+
+// Open the dataset of 'count' elements that 'config' describes, writing it first if it
+// does not exist yet. Falls back to an in-memory dataset when the file cannot be written
+template<typename Element>
+void openDataset(MappedDataset<Element>& dataset, const DatasetConfig& config, const uint64_t count)
+{
+  const std::string path = datasetPath(config, sizeof(Element), count);
+  const uint64_t swaps = datasetSwaps(config, count);
+  if (dataset.open(path) && dataset.matches(count, config.distribution, config.seed, swaps)) {
+    return;
+  }
+  if (makeDirectory(config.directory)
+      && writeDataset<Element>(path, count, config.distribution, config.seed, swaps)
+      && dataset.open(path)) {
+    return;
+  }
+
+  static bool warned = false;
+  if (!warned) {
+    std::cerr << "Could not write datasets to " << config.directory << ", generating them in memory" << std::endl;
+    warned = true;
+  }
+  dataset.generate(count, config.distribution, config.seed, swaps);
+}
+
+#endif // DATASET_H_
@@ -0,0 +1,128 @@
+#ifndef ELEMENT_TYPES_H_
+#define ELEMENT_TYPES_H_
+
+// Element types with owning members, to be compared with the trivially copyable
+// POD<Size>. When std::vector or std::deque shift elements for an insert these are
+// moved or copied one by one instead of a plain memmove. std::list nodes never move.
+//
+// All of them are created from a POD<Size>, sorted on the POD key (a[0]) and hold
+// the whole POD as a heap allocated payload.
+// Include "pod_performance.h" before this file.
+
+#include <memory>
+#include <vector>
+
+
+// Move-only: unique_ptr payload, the implicit (noexcept) move is used for shifting
+template<Number Size>
+struct MoveOnlyRecord
+{
+  Number key;
+  std::unique_ptr<POD<Size>> payload;
+
+  explicit MoveOnlyRecord(const POD<Size>& pod) : key(pod.a[0]), payload(new POD<Size>(pod)) {}
+  MoveOnlyRecord(MoveOnlyRecord&&) = default;
+  MoveOnlyRecord& operator=(MoveOnlyRecord&&) = default;
+
+  bool operator>=(const MoveOnlyRecord& b) const { return key >= b.key; }
+  static const char* name() { return "move_only"; }
+};
+
+
+// Copy-only: the user declared copy suppresses the implicit move so every shift
+// is a deep copy of the payload
+template<Number Size>
+struct HeavyCopyRecord
+{
+  Number key;
+  std::vector<Number> payload;
+
+  explicit HeavyCopyRecord(const POD<Size>& pod) : key(pod.a[0]), payload(pod.a, pod.a + Size) {}
+  HeavyCopyRecord(const HeavyCopyRecord& other) : key(other.key), payload(other.payload) {}
+  HeavyCopyRecord& operator=(const HeavyCopyRecord& other)
+  {
+    key = other.key;
+    payload = other.payload;
+    return *this;
+  }
+
+  bool operator>=(const HeavyCopyRecord& b) const { return key >= b.key; }
+  static const char* name() { return "heavy_copy"; }
+};
+
+
+// Copyable with a non-trivial noexcept move. std::vector moves on regrowth
+template<Number Size>
+struct NoexceptMoveRecord
+{
+  Number key;
+  std::vector<Number> payload;
+
+  explicit NoexceptMoveRecord(const POD<Size>& pod) : key(pod.a[0]), payload(pod.a, pod.a + Size) {}
+  NoexceptMoveRecord(const NoexceptMoveRecord&) = default;
+  NoexceptMoveRecord& operator=(const NoexceptMoveRecord&) = default;
+  NoexceptMoveRecord(NoexceptMoveRecord&& other) noexcept : key(other.key), payload(std::move(other.payload)) {}
+  NoexceptMoveRecord& operator=(NoexceptMoveRecord&& other) noexcept
+  {
+    key = other.key;
+    payload = std::move(other.payload);
+    return *this;
+  }
+
+  bool operator>=(const NoexceptMoveRecord& b) const { return key >= b.key; }
+  static const char* name() { return "noexcept_move"; }
+};
+
+
+// Same as above but the move is NOT noexcept. std::vector regrowth must then copy
+// (std::move_if_noexcept) to keep its strong exception guarantee
+template<Number Size>
+struct ThrowingMoveRecord
+{
+  Number key;
+  std::vector<Number> payload;
+
+  explicit ThrowingMoveRecord(const POD<Size>& pod) : key(pod.a[0]), payload(pod.a, pod.a + Size) {}
+  ThrowingMoveRecord(const ThrowingMoveRecord&) = default;
+  ThrowingMoveRecord& operator=(const ThrowingMoveRecord&) = default;
+  ThrowingMoveRecord(ThrowingMoveRecord&& other) : key(other.key), payload(std::move(other.payload)) {}
+  ThrowingMoveRecord& operator=(ThrowingMoveRecord&& other)
+  {
+    key = other.key;
+    payload = std::move(other.payload);
+    return *this;
+  }
+
+  bool operator>=(const ThrowingMoveRecord& b) const { return key >= b.key; }
+  static const char* name() { return "throwing_move"; }
+};
+
+
+// The heap payload of every record, for the warm and clflush modes of cache_mode.h
+template<Number Size, typename Visit>
+void forEachOwnedBlock(const MoveOnlyRecord<Size>& record, Visit visit)
+{
+  if (record.payload) {
+    visit(record.payload.get(), sizeof(POD<Size>));
+  }
+}
+
+template<Number Size, typename Visit>
+void forEachOwnedBlock(const HeavyCopyRecord<Size>& record, Visit visit)
+{
+  visit(record.payload.data(), record.payload.size() * sizeof(Number));
+}
+
+template<Number Size, typename Visit>
+void forEachOwnedBlock(const NoexceptMoveRecord<Size>& record, Visit visit)
+{
+  visit(record.payload.data(), record.payload.size() * sizeof(Number));
+}
+
+template<Number Size, typename Visit>
+void forEachOwnedBlock(const ThrowingMoveRecord<Size>& record, Visit visit)
+{
+  visit(record.payload.data(), record.payload.size() * sizeof(Number));
+}
+
+#endif // ELEMENT_TYPES_H_
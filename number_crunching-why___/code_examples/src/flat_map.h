@@ -0,0 +1,114 @@
+#ifndef FLAT_MAP_H_
+#define FLAT_MAP_H_
+
+// Flat sorted map: the keys and the values are kept in two vectors, sorted on the key.
+// A lookup is a binary search over the dense key vector only, so the (possibly big)
+// values are not dragged through the cache while searching. Insert and erase shift
+// both vectors, i.e. O(n), just like the linear insert into a vector.
+//
+// Only what the key-value workloads need is implemented: insert, find, erase, a bulk
+// build from unsorted input, ordered iteration by index and forEachRange.
+
+#include <cstddef>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+
+template<typename Key, typename Value>
+class FlatMap
+{
+  std::vector<Key> keys_;
+  std::vector<Value> values_;
+
+  size_t lowerBound(const Key& key) const
+  {
+    return size_t(std::lower_bound(keys_.begin(), keys_.end(), key) - keys_.begin());
+  }
+
+public:
+  typedef Key key_type;
+  typedef Value mapped_type;
+
+  FlatMap() {}
+
+  FlatMap(const FlatMap&) = delete;
+  FlatMap& operator=(const FlatMap&) = delete;
+
+  // Returns false if the key was already there, the old value is then kept
+  bool insert(const Key& key, const Value& value)
+  {
+    const size_t index = lowerBound(key);
+    if (index != keys_.size() && keys_[index] == key) {
+      return false;
+    }
+    keys_.insert(keys_.begin() + index, key);
+    values_.insert(values_.begin() + index, value);
+    return true;
+  }
+
+  // nullptr if the key is not there
+  const Value* find(const Key& key) const
+  {
+    const size_t index = lowerBound(key);
+    if (index != keys_.size() && keys_[index] == key) {
+      return &values_[index];
+    }
+    return nullptr;
+  }
+
+  bool erase(const Key& key)
+  {
+    const size_t index = lowerBound(key);
+    if (index == keys_.size() || keys_[index] != key) {
+      return false;
+    }
+    keys_.erase(keys_.begin() + index);
+    values_.erase(values_.begin() + index);
+    return true;
+  }
+
+  // Replace the content with the (key, value) pairs of [first, last), unsorted and with
+  // duplicates. Sort once instead of n O(n) inserts, the first of equal keys is kept
+  template<typename Iterator, typename KeyOf>
+  void assign(Iterator first, Iterator last, KeyOf key_of)
+  {
+    std::vector<std::pair<Key, size_t>> order;
+    size_t position = 0;
+    for (Iterator itr = first; itr != last; ++itr, ++position) {
+      order.push_back(std::make_pair(key_of(*itr), position));
+    }
+    std::sort(order.begin(), order.end());
+    order.erase(std::unique(order.begin(), order.end(),
+                            [](const std::pair<Key, size_t>& a, const std::pair<Key, size_t>& b) { return a.first == b.first; }),
+                order.end());
+
+    keys_.clear();
+    values_.clear();
+    keys_.reserve(order.size());
+    values_.reserve(order.size());
+    for (auto& entry : order)
+    {
+      keys_.push_back(entry.first);
+      values_.push_back(*(first + entry.second));
+    }
+  }
+
+  size_t size() const { return keys_.size(); }
+  bool empty() const { return keys_.empty(); }
+  void clear() { keys_.clear(); values_.clear(); }
+
+  // in key order
+  const Key& keyAt(size_t index) const { return keys_[index]; }
+  const Value& valueAt(size_t index) const { return values_[index]; }
+
+  // Both vectors, for the cache modes of cache_mode.h, visit(address, bytes)
+  template<typename Visit>
+  void forEachRange(Visit visit) const
+  {
+    visit(keys_.data(), keys_.size() * sizeof(Key));
+    visit(values_.data(), values_.size() * sizeof(Value));
+  }
+};
+
+#endif // FLAT_MAP_H_
@@ -0,0 +1,162 @@
+#ifndef FORK_ISOLATION_H_
+#define FORK_ISOLATION_H_
+
+// Run a measurement in a forked child process. The child starts as a copy of the
+// parent but whatever it allocates, maps or pollutes is thrown away when it exits,
+// so the next measurement does not inherit allocator caches, page mappings or RSS.
+// The result is sent back over a pipe. A child that does not deliver within the
+// timeout is killed, i.e. a runaway O(n^2) cell cannot hang the whole run.
+//
+// 'Result' must be trivially copyable, it is sent as raw bytes. Only for POSIX systems,
+// elsewhere runIsolated returns IsolationStatus::kUnsupported.
+
+#include <string>
+#include <cerrno>
+#include <chrono>
+#include <iostream>
+#include <type_traits>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#define FORK_ISOLATION_SUPPORTED 1
+#endif
+
+
+enum class IsolationStatus { kOk, kTimeout, kFailed, kUnsupported };
+
+const char* isolationStatusName(IsolationStatus status)
+{
+  switch (status)
+  {
+    case IsolationStatus::kOk:       return "ok";
+    case IsolationStatus::kTimeout:  return "timeout";
+    case IsolationStatus::kFailed:   return "failed";
+    default:                         return "unsupported";
+  }
+}
+
+bool isolationSupported()
+{
+#if defined(FORK_ISOLATION_SUPPORTED)
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+#if defined(FORK_ISOLATION_SUPPORTED)
+namespace isolation_detail
+{
+  // Read exactly 'bytes' or fail. Gives up when 'deadline' passes, unless 'timeout_ms' is 0
+  IsolationStatus readAll(int fd, char* buffer, size_t bytes, long long timeout_ms,
+                          const std::chrono::steady_clock::time_point& deadline)
+  {
+    size_t done = 0;
+    while (done != bytes)
+    {
+      int wait_ms = -1;
+      if (timeout_ms > 0)
+      {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0) {
+          return IsolationStatus::kTimeout;
+        }
+        wait_ms = int(left);
+      }
+
+      pollfd readable = {fd, POLLIN, 0};
+      const int ready = poll(&readable, 1, wait_ms);
+      if (0 == ready) {
+        return IsolationStatus::kTimeout;
+      }
+      if (ready < 0) {
+        if (EINTR == errno) {
+          continue;
+        }
+        return IsolationStatus::kFailed;
+      }
+
+      const ssize_t count = read(fd, buffer + done, bytes - done);
+      if (count <= 0) { // EOF: the child died before it delivered
+        if (count < 0 && EINTR == errno) {
+          continue;
+        }
+        return IsolationStatus::kFailed;
+      }
+      done += size_t(count);
+    }
+    return IsolationStatus::kOk;
+  }
+} // isolation_detail
+#endif
+
+
+// Run 'measure' in a child process and copy its returned Result into 'result'.
+// timeout_ms = 0 means wait for as long as it takes
+template<typename Result, typename Measure>
+IsolationStatus runIsolated(Measure measure, const long long timeout_ms, Result& result)
+{
+  static_assert(std::is_trivially_copyable<Result>::value, "the result is sent as raw bytes");
+#if defined(FORK_ISOLATION_SUPPORTED)
+  int fds[2];
+  if (0 != pipe(fds)) {
+    return IsolationStatus::kFailed;
+  }
+  std::cout << std::flush; // or the child would print the buffered output again
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+  const pid_t child = fork();
+  if (child < 0)
+  {
+    close(fds[0]);
+    close(fds[1]);
+    return IsolationStatus::kFailed;
+  }
+
+  if (0 == child)
+  {
+    close(fds[0]);
+    Result measured = measure();
+    const char* bytes = reinterpret_cast<const char*>(&measured);
+    size_t done = 0;
+    while (done != sizeof(Result))
+    {
+      const ssize_t count = write(fds[1], bytes + done, sizeof(Result) - done);
+      if (count <= 0) {
+        _exit(1);
+      }
+      done += size_t(count);
+    }
+    std::cout << std::flush;
+    _exit(0); // no destructors or atexit handlers of the parent's state
+  }
+
+  close(fds[1]);
+  Result received;
+  IsolationStatus status = isolation_detail::readAll(fds[0], reinterpret_cast<char*>(&received),
+                                                     sizeof(Result), timeout_ms, deadline);
+  close(fds[0]);
+  if (IsolationStatus::kTimeout == status) {
+    kill(child, SIGKILL);
+  }
+
+  int exit_status = 0;
+  while (waitpid(child, &exit_status, 0) < 0 && EINTR == errno) {}
+  if (IsolationStatus::kOk == status && !(WIFEXITED(exit_status) && 0 == WEXITSTATUS(exit_status))) {
+    status = IsolationStatus::kFailed;
+  }
+  if (IsolationStatus::kOk == status) {
+    result = received;
+  }
+  return status;
+#else
+  (void)measure; (void)timeout_ms; (void)result;
+  return IsolationStatus::kUnsupported;
+#endif
+}
+
+#endif // FORK_ISOLATION_H_
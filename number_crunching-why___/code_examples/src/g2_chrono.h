@@ -6,12 +6,18 @@
 #include <chrono>
 #include <thread>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 namespace g2
 {       
   typedef std::chrono::high_resolution_clock clock;
   typedef std::chrono::microseconds microseconds;
   typedef std::chrono::milliseconds milliseconds;
+  typedef std::chrono::nanoseconds nanoseconds;
 
   clock::time_point now(){return clock::now();}
 
@@ -21,6 +27,64 @@ namespace g2
   milliseconds intervalMs(const clock::time_point& t1,const clock::time_point& t0)
   {return std::chrono::duration_cast<milliseconds>(t1 - t0);}
 
+  // Raw time stamp counter. Very cheap to read but it is not serializing, use it for
+  // many short intervals (e.g. one per insert). Without a TSC the clock ticks are used
+  typedef unsigned long long cycle_count;
+  cycle_count cycles()
+  {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return clock::now().time_since_epoch().count();
+#endif
+  }
+
+  // Serializing reads of the time stamp counter for the start and stop of a timed region.
+  // The lfence keeps earlier instructions out of the region, rdtscp waits for all
+  // instructions in the region to finish. Assumes an invariant TSC (any x86 of the last decade)
+  cycle_count cyclesStart()
+  {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    _mm_lfence();
+    cycle_count start = __rdtsc();
+    _mm_lfence();
+    return start;
+#else
+    return cycles();
+#endif
+  }
+
+  cycle_count cyclesStop()
+  {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    unsigned int aux;
+    cycle_count stop = __rdtscp(&aux);
+    _mm_lfence();
+    return stop;
+#else
+    return cycles();
+#endif
+  }
+
+  // Cycles per nanosecond, calibrated against steady_clock the first time it is called
+  // (~50ms busy wait). Call it at startup so that the calibration is not measured
+  double cyclesPerNs()
+  {
+    static const double cycles_per_ns = []() -> double {
+      typedef std::chrono::steady_clock steady;
+      const steady::time_point t0 = steady::now();
+      const cycle_count c0 = cyclesStart();
+      while (steady::now() - t0 < std::chrono::milliseconds(50)) {}
+      const cycle_count c1 = cyclesStop();
+      const auto ns = std::chrono::duration_cast<nanoseconds>(steady::now() - t0).count();
+      return double(c1 - c0) / double(ns);
+    }();
+    return cycles_per_ns;
+  }
+
+  nanoseconds cyclesToNs(cycle_count count)
+  {return nanoseconds((long long)(double(count) / cyclesPerNs()));}
+
 
   template<typename Duration>
   void short_sleep(Duration d) // thanks to Anthony Williams for the suggestion of short_sleep
@@ -40,6 +104,20 @@ namespace g2
     microseconds elapsedUs()            { return intervalUs(now(), start_);}
     milliseconds elapsedMs()            {return intervalMs(now(), start_);}
   };
+
+  // Same interface as StopWatch but on the time stamp counter, with nanoseconds and
+  // cycles. For the short intervals where the clock's resolution would show 0
+  class CycleStopWatch
+  {
+    cycle_count start_;
+  public:
+    CycleStopWatch() : start_(cyclesStart()){}
+    cycle_count restart()               { start_ = cyclesStart(); return start_;}
+    cycle_count elapsedCycles()         { return cyclesStop() - start_;}
+    nanoseconds elapsedNs()             { return cyclesToNs(elapsedCycles());}
+    microseconds elapsedUs()            { return std::chrono::duration_cast<microseconds>(elapsedNs());}
+    milliseconds elapsedMs()            { return std::chrono::duration_cast<milliseconds>(elapsedNs());}
+  };
 } // g2
 
 
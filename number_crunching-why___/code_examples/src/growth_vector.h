@@ -0,0 +1,190 @@
+#ifndef GROWTH_VECTOR_H_
+#define GROWTH_VECTOR_H_
+
+// Vector with a configurable growth policy and relocation strategy. It counts every
+// reallocation, the bytes that had to be copied and the slowest single regrowth so
+// that the cost of growing can be shown next to the insert time.
+//
+// Growth policies:
+//   GrowByFactor<3,2>   1.5x, what MSVC's std::vector does
+//   GrowByFactor<2,1>   2x, what libstdc++ and libc++ std::vector does
+//   ExactReserve        the final size is reserved up front, no regrowth at all
+//
+// Relocation:
+//   MoveRelocation      allocate a new buffer, move the elements, free the old one
+//   ReallocRelocation   std::realloc, only for trivially copyable types. It can extend
+//                       the block in place and (glibc) big blocks above the mmap threshold
+//                       are moved with mremap, i.e. remapped instead of copied
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include "g2_chrono.h"
+
+
+struct GrowthStats
+{
+  size_t reallocations;
+  size_t bytes_copied;           // for realloc: upper bound, a moved block might be remapped
+  long long longest_regrowth_us;
+
+  GrowthStats() : reallocations(0), bytes_copied(0), longest_regrowth_us(0) {}
+};
+
+
+template<size_t Numerator, size_t Denominator>
+struct GrowByFactor
+{
+  static_assert(Numerator > Denominator, "growth factor must be > 1");
+  static const bool kReserveUpFront = false;
+  static size_t nextCapacity(size_t capacity, size_t needed)
+  {
+    size_t next = capacity * Numerator / Denominator;
+    return std::max(next, std::max(needed, size_t(1)));
+  }
+};
+
+struct ExactReserve
+{
+  static const bool kReserveUpFront = true;
+  static size_t nextCapacity(size_t /*capacity*/, size_t needed) { return needed; }
+};
+
+
+struct MoveRelocation
+{
+  template<typename T>
+  static T* relocate(T* data, size_t size, size_t new_capacity, GrowthStats& stats)
+  {
+    T* fresh = static_cast<T*>(::operator new(new_capacity * sizeof(T)));
+    for (size_t idx = 0; idx != size; ++idx)
+    {
+      new (fresh + idx) T(std::move(data[idx]));
+      data[idx].~T();
+    }
+    ::operator delete(data);
+    stats.bytes_copied += size * sizeof(T);
+    return fresh;
+  }
+
+  template<typename T>
+  static void release(T* data) { ::operator delete(data); }
+};
+
+struct ReallocRelocation
+{
+  template<typename T>
+  static T* relocate(T* data, size_t size, size_t new_capacity, GrowthStats& stats)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "realloc relocation needs a trivially copyable type");
+    void* fresh = std::realloc(data, new_capacity * sizeof(T));
+    if (nullptr == fresh) {
+      throw std::bad_alloc();
+    }
+    if (fresh != data) {
+      stats.bytes_copied += size * sizeof(T);
+    }
+    return static_cast<T*>(fresh);
+  }
+
+  template<typename T>
+  static void release(T* data) { std::free(data); }
+};
+
+
+
+template<typename T, typename Growth, typename Relocation = MoveRelocation>
+class GrowthVector
+{
+  T* data_;
+  size_t size_;
+  size_t capacity_;
+  GrowthStats stats_;
+
+  void regrow(size_t new_capacity)
+  {
+    g2::StopWatch watch;
+    data_ = Relocation::relocate(data_, size_, new_capacity, stats_);
+    capacity_ = new_capacity;
+    ++stats_.reallocations;
+    stats_.longest_regrowth_us = std::max(stats_.longest_regrowth_us, (long long)watch.elapsedUs().count());
+  }
+
+public:
+  typedef T value_type;
+  typedef T* iterator;
+  typedef const T* const_iterator;
+
+  GrowthVector() : data_(nullptr), size_(0), capacity_(0) {}
+  ~GrowthVector()
+  {
+    clear();
+    Relocation::release(data_);
+  }
+
+  GrowthVector(const GrowthVector&) = delete;
+  GrowthVector& operator=(const GrowthVector&) = delete;
+
+  iterator begin()              { return data_; }
+  iterator end()                { return data_ + size_; }
+  const_iterator begin() const  { return data_; }
+  const_iterator end() const    { return data_ + size_; }
+
+  size_t size() const           { return size_; }
+  size_t capacity() const       { return capacity_; }
+  bool empty() const            { return 0 == size_; }
+  const GrowthStats& stats() const { return stats_; }
+
+  // ExactReserve relies on this being called with the final size before inserting
+  void reserve(size_t wanted)
+  {
+    if (wanted > capacity_) {
+      regrow(wanted);
+    }
+  }
+
+  void push_back(const T& value)
+  {
+    insert(end(), value);
+  }
+
+  iterator insert(iterator pos, const T& value)
+  {
+    const size_t index = pos - data_;
+    T copy(value);
+    if (size_ == capacity_) {
+      regrow(Growth::nextCapacity(capacity_, size_ + 1));
+    }
+
+    if (index == size_) {
+      new (data_ + size_) T(std::move(copy));
+    } else {
+      new (data_ + size_) T(std::move(data_[size_ - 1]));
+      std::move_backward(data_ + index, data_ + size_ - 1, data_ + size_);
+      data_[index] = std::move(copy);
+    }
+    ++size_;
+    return data_ + index;
+  }
+
+  iterator erase(iterator pos)
+  {
+    std::move(pos + 1, data_ + size_, pos);
+    --size_;
+    data_[size_].~T();
+    return pos;
+  }
+
+  void clear()
+  {
+    for (size_t idx = 0; idx != size_; ++idx) {
+      data_[idx].~T();
+    }
+    size_ = 0;
+  }
+};
+
+#endif // GROWTH_VECTOR_H_
@@ -0,0 +1,100 @@
+#ifndef HEAP_AGING_H_
+#define HEAP_AGING_H_
+
+// Aged heap: a long running process has allocated and freed memory of mixed sizes
+// for weeks. Its free lists are scattered all over the heap, so consecutive list
+// nodes no longer end up next to each other as they do on a fresh heap.
+//
+// An AgedHeap runs a random malloc/free churn of mixed sizes in its constructor and
+// keeps the survivors alive until it is destroyed. Create it before the containers
+// are built and keep it alive during the measurement.
+
+#include <string>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <new>
+#include <algorithm>
+
+
+enum class HeapState { kFresh, kAged };
+
+const char* heapStateName(HeapState state)
+{
+  return (HeapState::kAged == state) ? "aged" : "fresh";
+}
+
+// Returns false for an unknown name
+bool parseHeapState(const std::string& name, HeapState& state)
+{
+  if ("fresh" == name) {
+    state = HeapState::kFresh;
+  } else if ("aged" == name) {
+    state = HeapState::kAged;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+
+struct HeapAgingConfig
+{
+  size_t operations;  // number of malloc or free calls
+  size_t max_live;    // most allocations alive at the same time
+  size_t min_bytes;   // allocation sizes are log-uniform in [min_bytes, max_bytes]
+  size_t max_bytes;
+  unsigned seed;
+
+  HeapAgingConfig() : operations(1000000), max_live(100000), min_bytes(8), max_bytes(4096), seed(2012) {}
+};
+
+
+class AgedHeap
+{
+  std::vector<void*> live_;
+
+public:
+  explicit AgedHeap(const HeapAgingConfig& config)
+  {
+    std::mt19937 engine(config.seed);
+    std::uniform_real_distribution<double> log_size(std::log(double(config.min_bytes)),
+                                                    std::log(double(config.max_bytes)));
+    std::bernoulli_distribution allocate(0.55); // slowly grow towards max_live
+    live_.reserve(config.max_live);
+
+    for (size_t op = 0; op != config.operations; ++op)
+    {
+      const bool can_allocate = live_.size() < config.max_live;
+      if (live_.empty() || (can_allocate && allocate(engine)))
+      {
+        const size_t bytes = size_t(std::exp(log_size(engine)));
+        char* memory = static_cast<char*>(::operator new(bytes));
+        memory[0] = char(op); // touch it, like a real user of the memory would
+        live_.push_back(memory);
+      }
+      else
+      {
+        std::uniform_int_distribution<size_t> pick(0, live_.size() - 1);
+        const size_t victim = pick(engine);
+        ::operator delete(live_[victim]);
+        live_[victim] = live_.back();
+        live_.pop_back();
+      }
+    }
+  }
+
+  ~AgedHeap()
+  {
+    for (auto memory : live_) {
+      ::operator delete(memory);
+    }
+  }
+
+  AgedHeap(const AgedHeap&) = delete;
+  AgedHeap& operator=(const AgedHeap&) = delete;
+
+  size_t liveAllocations() const { return live_.size(); }
+};
+
+#endif // HEAP_AGING_H_
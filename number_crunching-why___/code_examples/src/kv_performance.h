@@ -0,0 +1,185 @@
+#ifndef KV_PERFORMANCE_H_
+#define KV_PERFORMANCE_H_
+
+// Key-value workloads on POD records: the key is a[0] and the whole POD is the value.
+// The maps compared are
+//   FlatMap              sorted key and value vectors (flat_map.h)
+//   std::map             red-black tree, one node per element
+//   std::unordered_map   chained hash table, one node per element
+//   OpenAddressingMap    linear probing in a flat slot array (open_addressing_map.h)
+//
+// The kv* functions give them one interface. Ordered iteration is free for the two
+// sorted maps, the hash maps have to collect and sort their keys first: that is
+// what an ordered walk over a hash map costs.
+// Include "pod_performance.h", "flat_map.h" and "open_addressing_map.h" before this file.
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+
+template<Number Size>
+Number keyOf(const POD<Size>& pod) { return pod.a[0]; }
+
+
+// std::map and std::unordered_map
+template<typename StdMap>
+bool stdInsert(StdMap& map, const typename StdMap::mapped_type& value)
+{
+  return map.insert(typename StdMap::value_type(keyOf(value), value)).second;
+}
+
+template<typename StdMap>
+const typename StdMap::mapped_type* stdFind(const StdMap& map, const Number key)
+{
+  auto itr = map.find(key);
+  return (itr == map.end()) ? nullptr : &itr->second;
+}
+
+template<typename Value>
+bool kvInsert(std::map<Number, Value>& map, const Value& value) { return stdInsert(map, value); }
+
+template<typename Value>
+bool kvInsert(std::unordered_map<Number, Value>& map, const Value& value) { return stdInsert(map, value); }
+
+template<typename Value>
+const Value* kvFind(const std::map<Number, Value>& map, const Number key) { return stdFind(map, key); }
+
+template<typename Value>
+const Value* kvFind(const std::unordered_map<Number, Value>& map, const Number key) { return stdFind(map, key); }
+
+template<typename Value>
+bool kvErase(std::map<Number, Value>& map, const Number key) { return map.erase(key) > 0; }
+
+template<typename Value>
+bool kvErase(std::unordered_map<Number, Value>& map, const Number key) { return map.erase(key) > 0; }
+
+template<typename Value, typename Visit>
+void kvForEachOrdered(const std::map<Number, Value>& map, Visit visit)
+{
+  for (auto& entry : map) {
+    visit(entry.first, entry.second);
+  }
+}
+
+template<typename Value, typename Visit>
+void kvForEach(const std::unordered_map<Number, Value>& map, Visit visit)
+{
+  for (auto& entry : map) {
+    visit(entry.first, entry.second);
+  }
+}
+
+template<typename Value, typename Visit>
+void kvForEachOrdered(const std::unordered_map<Number, Value>& map, Visit visit)
+{
+  std::vector<std::pair<Number, const Value*>> entries;
+  entries.reserve(map.size());
+  kvForEach(map, [&](const Number key, const Value& value) { entries.push_back(std::make_pair(key, &value)); });
+  std::sort(entries.begin(), entries.end());
+  for (auto& entry : entries) {
+    visit(entry.first, *entry.second);
+  }
+}
+
+
+// FlatMap and OpenAddressingMap have insert(key, value), find and erase of their own
+template<typename Value>
+bool kvInsert(FlatMap<Number, Value>& map, const Value& value) { return map.insert(keyOf(value), value); }
+
+template<typename Value>
+bool kvInsert(OpenAddressingMap<Number, Value>& map, const Value& value) { return map.insert(keyOf(value), value); }
+
+template<typename Value>
+const Value* kvFind(const FlatMap<Number, Value>& map, const Number key) { return map.find(key); }
+
+template<typename Value>
+const Value* kvFind(const OpenAddressingMap<Number, Value>& map, const Number key) { return map.find(key); }
+
+template<typename Value>
+bool kvErase(FlatMap<Number, Value>& map, const Number key) { return map.erase(key); }
+
+template<typename Value>
+bool kvErase(OpenAddressingMap<Number, Value>& map, const Number key) { return map.erase(key); }
+
+// Insert one by one, the flat map has a bulk build of its own
+template<typename Map, typename Values>
+void kvBuild(Map& map, const Values& values)
+{
+  for (auto& value : values) {
+    kvInsert(map, value);
+  }
+}
+
+// A flat map is built in one go, a lookup table is not filled one by one
+template<typename Value, typename Values>
+void kvBuild(FlatMap<Number, Value>& map, const Values& values)
+{
+  map.assign(values.begin(), values.end(), [](const Value& value) { return keyOf(value); });
+}
+
+template<typename Value, typename Visit>
+void kvForEachOrdered(const FlatMap<Number, Value>& map, Visit visit)
+{
+  for (size_t index = 0; index != map.size(); ++index) {
+    visit(map.keyAt(index), map.valueAt(index));
+  }
+}
+
+template<typename Value, typename Visit>
+void kvForEach(const OpenAddressingMap<Number, Value>& map, Visit visit)
+{
+  map.forEach(visit);
+}
+
+template<typename Value, typename Visit>
+void kvForEachOrdered(const OpenAddressingMap<Number, Value>& map, Visit visit)
+{
+  std::vector<std::pair<Number, const Value*>> entries;
+  entries.reserve(map.size());
+  map.forEach([&](const Number key, const Value& value) { entries.push_back(std::make_pair(key, &value)); });
+  std::sort(entries.begin(), entries.end());
+  for (auto& entry : entries) {
+    visit(entry.first, *entry.second);
+  }
+}
+
+
+// In whatever order is the cheapest, for the sorted maps that is the key order
+template<typename Value, typename Visit>
+void kvForEach(const std::map<Number, Value>& map, Visit visit) { kvForEachOrdered(map, visit); }
+
+template<typename Value, typename Visit>
+void kvForEach(const FlatMap<Number, Value>& map, Visit visit) { kvForEachOrdered(map, visit); }
+
+
+// Read one word of the value, so the lookup cannot be optimized away and the
+// value's cache line is actually touched
+template<Number Size>
+Number touchValue(const POD<Size>* value)
+{
+  return (nullptr == value) ? 0 : value->a[Size - 1] + 1;
+}
+
+
+// One operation of the mixed workload, chosen from the position in the input:
+// 7 of 10 are lookups, 2 inserts of a new key and 1 erase
+template<typename Map, Number Size>
+Number kvMixedOne(const size_t position, const POD<Size>& value, const Number nbr_of_keys, Map& map)
+{
+  const size_t kind = position % 10;
+  if (kind < 7) {
+    return touchValue(kvFind(map, keyOf(value)));
+  }
+  if (kind < 9) {
+    POD<Size> fresh = value;
+    fresh.a[0] += nbr_of_keys; // outside the initial key range
+    return kvInsert(map, fresh) ? 1 : 0;
+  }
+  return kvErase(map, keyOf(value)) ? 1 : 0;
+}
+
+
+#endif // KV_PERFORMANCE_H_
@@ -0,0 +1,161 @@
+#ifndef LATENCY_HISTOGRAM_H_
+#define LATENCY_HISTOGRAM_H_
+
+// HDR style latency histogram: values below 2^kSubBucketBits are counted exactly,
+// above that every power of two is split in 2^(kSubBucketBits-1) linear sub buckets.
+// With kSubBucketBits = 6 the relative error is at most ~3% over the whole 64 bit range,
+// at a fixed size of ~1900 counters. Recording is a couple of shifts and an increment.
+//
+// recordEach / recordTimes time every single operation with g2::cycles(), so that a
+// vector reallocation or a page fault storm shows up in the tail instead of
+// disappearing into the total.
+// Include "g2_chrono.h" before this file.
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+
+class LatencyHistogram
+{
+  static const unsigned kSubBucketBits = 6;
+  static const uint64_t kSubBuckets = 1ull << kSubBucketBits;
+  static const uint64_t kHalfSubBuckets = kSubBuckets / 2;
+
+  std::vector<uint64_t> counts_;
+  uint64_t total_;
+  uint64_t max_;
+
+  static unsigned highestBit(uint64_t value)
+  {
+    unsigned bit = 0;
+    while (value >>= 1) {
+      ++bit;
+    }
+    return bit;
+  }
+
+  // bucket index and the number of low bits that the bucket ignores
+  static size_t indexOf(uint64_t value, unsigned& shift)
+  {
+    if (value < kSubBuckets) {
+      shift = 0;
+      return size_t(value);
+    }
+    shift = highestBit(value) - (kSubBucketBits - 1);
+    return size_t(kSubBuckets + (shift - 1) * kHalfSubBuckets + ((value >> shift) - kHalfSubBuckets));
+  }
+
+  // highest value that is counted in the bucket at 'index'
+  static uint64_t highestValueAt(size_t index)
+  {
+    if (index < kSubBuckets) {
+      return index;
+    }
+    const uint64_t shift = (index - kSubBuckets) / kHalfSubBuckets + 1;
+    const uint64_t sub_bucket = (index - kSubBuckets) % kHalfSubBuckets + kHalfSubBuckets;
+    return (sub_bucket << shift) + ((1ull << shift) - 1);
+  }
+
+public:
+  LatencyHistogram()
+    : counts_(size_t(kSubBuckets + (64 - kSubBucketBits + 1) * kHalfSubBuckets), 0)
+    , total_(0), max_(0) {}
+
+  void record(uint64_t value)
+  {
+    unsigned shift;
+    ++counts_[indexOf(value, shift)];
+    ++total_;
+    max_ = std::max(max_, value);
+  }
+
+  // Add the counts of 'other', e.g. the histogram of another thread
+  void merge(const LatencyHistogram& other)
+  {
+    for (size_t index = 0; index != counts_.size(); ++index) {
+      counts_[index] += other.counts_[index];
+    }
+    total_ += other.total_;
+    max_ = std::max(max_, other.max_);
+  }
+
+  void reset()
+  {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    total_ = 0;
+    max_ = 0;
+  }
+
+  uint64_t count() const { return total_; }
+  uint64_t max() const   { return max_; }
+
+  // Value at 'percentile' (0-100]. Reported as the highest value of its bucket, but
+  // never more than the recorded max
+  uint64_t valueAtPercentile(double percentile) const
+  {
+    if (0 == total_) {
+      return 0;
+    }
+    uint64_t wanted = uint64_t(double(total_) * percentile / 100.0 + 0.5);
+    wanted = std::min(total_, std::max(uint64_t(1), wanted));
+    uint64_t seen = 0;
+    for (size_t index = 0; index != counts_.size(); ++index)
+    {
+      seen += counts_[index];
+      if (seen >= wanted) {
+        return std::min(max_, highestValueAt(index));
+      }
+    }
+    return max_;
+  }
+};
+
+
+// The numbers that are reported. A plain struct so it can be passed around as bytes
+struct LatencySummary
+{
+  uint64_t count;
+  uint64_t p50;
+  uint64_t p99;
+  uint64_t p999;
+  uint64_t max;
+};
+
+LatencySummary summarize(const LatencyHistogram& histogram)
+{
+  LatencySummary summary;
+  summary.count = histogram.count();
+  summary.p50 = histogram.valueAtPercentile(50);
+  summary.p99 = histogram.valueAtPercentile(99);
+  summary.p999 = histogram.valueAtPercentile(99.9);
+  summary.max = histogram.max();
+  return summary;
+}
+
+
+// Run 'operation' on every value and record how many cycles each call took
+template<typename Values, typename Operation>
+void recordEach(const Values& values, Operation operation, LatencyHistogram& histogram)
+{
+  for (auto& value : values)
+  {
+    const g2::cycle_count start = g2::cycles();
+    operation(value);
+    histogram.record(g2::cycles() - start);
+  }
+}
+
+// Run 'operation' 'times' times and record how many cycles each call took
+template<typename Operation>
+void recordTimes(const size_t times, Operation operation, LatencyHistogram& histogram)
+{
+  for (size_t count = 0; count != times; ++count)
+  {
+    const g2::cycle_count start = g2::cycles();
+    operation();
+    histogram.record(g2::cycles() - start);
+  }
+}
+
+#endif // LATENCY_HISTOGRAM_H_
@@ -0,0 +1,53 @@
+#ifndef LAYOUT_LOOKUP_H_
+#define LAYOUT_LOOKUP_H_
+
+// Lookup throughput of read mostly sorted data in different layouts. A lookup finds
+// the first element with a key >= the searched key (keyOf), one lookup at a time:
+//   std::list        sorted, linear walk
+//   std::vector      sorted, std::lower_bound
+//   EytzingerArray   BFS layout, branchless with prefetch (sorted_layouts.h)
+//   VebArray         van Emde Boas layout, branchless (sorted_layouts.h)
+// Include "pod_performance.h", "kv_performance.h", "sorted_layouts.h" and
+// "batched_lookup.h" (buildSorted for list and vector) before this file.
+
+#include <list>
+#include <vector>
+#include <algorithm>
+
+
+template<typename T>
+const T* sortedLookup(const std::list<T>& list, const Number key)
+{
+  auto itr = std::find_if(list.begin(), list.end(), [&](const T& value) { return keyOf(value) >= key; });
+  return (itr == list.end()) ? nullptr : &*itr;
+}
+
+template<typename T>
+const T* sortedLookup(const std::vector<T>& vector, const Number key)
+{
+  auto itr = std::lower_bound(vector.begin(), vector.end(), key,
+                              [](const T& value, const Number searched) { return keyOf(value) < searched; });
+  return (itr == vector.end()) ? nullptr : &*itr;
+}
+
+template<typename T>
+const T* sortedLookup(const EytzingerArray<Number, T>& layout, const Number key) { return layout.lowerBound(key); }
+
+template<typename T>
+const T* sortedLookup(const VebArray<Number, T>& layout, const Number key) { return layout.lowerBound(key); }
+
+
+template<typename Values, typename T>
+void buildSorted(const Values& values, EytzingerArray<Number, T>& layout)
+{
+  layout.assign(values.begin(), values.end(), [](const T& value) { return keyOf(value); });
+}
+
+template<typename Values, typename T>
+void buildSorted(const Values& values, VebArray<Number, T>& layout)
+{
+  layout.assign(values.begin(), values.end(), [](const T& value) { return keyOf(value); });
+}
+
+
+#endif // LAYOUT_LOOKUP_H_
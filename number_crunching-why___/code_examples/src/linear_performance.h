@@ -13,10 +13,17 @@
 #include <iostream>
 #include <iomanip>
 #include <random>
+#include <functional>
+#include <future>
 #include <string>
 #include <numeric>
 #include <cassert>
+#include <cstdint>
 #include <algorithm>
+#include "small_vector.h"
+#include "dataset.h"
+#include "packed_sorted.h"
+#include "cache_mode.h"
 
 
 typedef unsigned int  Number;
@@ -24,14 +31,27 @@ typedef std::list<Number>           NumbersInList;
 typedef std::vector<Number>         NumbersInVector;
 typedef long long int               TimeValue;
 
+// Most small collections hold fewer than 64 items, keep that many in-place before
+// falling back to the heap. The small vector column is only run up to
+// 'kSmallVectorMaxElements', above that the inline buffer is irrelevant
+const size_t kSmallVectorInlineCapacity = 64;
+const size_t kSmallVectorMaxElements = 5000;
+typedef SmallVector<Number, kSmallVectorInlineCapacity> NumbersInSmallVector;
+
+// The random input is read from datasets/ (dataset.h), the same numbers on every run
+typedef MappedDataset<Number>       NumbersInDataset;
+
+// Delta encoded and bit packed blocks (packed_sorted.h), sorted on every insert
+typedef PackedSortedNumbers         NumbersPacked;
+
 
 
 
 // Use a template approach to use functor, function pointer or lambda to insert an
 // element in the input container and return the "time result".
 // Search is LINEAR. Elements are insert in SORTED order
-template<typename Container>
-void linearInsertion(const NumbersInVector& numbers, Container& container)
+template<typename Numbers, typename Container>
+void linearInsertion(const Numbers& numbers, Container& container)
 {
     std::for_each(numbers.begin(), numbers.end(),
                   [&](const Number& n)
@@ -47,40 +67,37 @@ void linearInsertion(const NumbersInVector& numbers, Container& container)
     });
 }
 
-// Measure time in milliseconds for linear insert in a std container
-template<typename Container>
-TimeValue linearInsertPerformance(const NumbersInVector& randoms, Container& container)
+// The packed numbers find the insert position themselves: a scan of the block
+// bases and a decode of one block
+template<typename Numbers>
+void linearInsertion(const Numbers& numbers, NumbersPacked& packed)
 {
-    g2::StopWatch watch;
-    linearInsertion(std::cref(randoms), container);
-    auto time = watch.elapsedMs().count();
-    return time;
+    for (auto& n : numbers) {
+        packed.insert(n);
+    }
 }
 
+// Measure time in nanoseconds for linear insert in a std container. The TSC based
+// stopwatch is used so that the 10 and 100 element rows do not show up as 0
+template<typename Numbers, typename Container>
+TimeValue linearInsertPerformance(const Numbers& randoms, Container& container)
+{
+    g2::CycleStopWatch watch;
+    linearInsertion(randoms, container);
+    auto time = watch.elapsedNs().count();
+    return time;
+}
 
 
-// Generate a random number using the 'mersenne twister distribution'
-// http://en.wikipedia.org/wiki/Mersenne_twister
-// Random numbers are chosen within the range limits of 'low' and 'high'
-auto randomNumber = [&](const Number& low, const Number& high) -> Number {
-    std::uniform_int_distribution<int> distribution(low, high);
-    std::mt19937 engine((unsigned int)time(0)); // Mersenne twister MT19937
-    auto generator = std::bind(distribution, engine);
-    return generator();
-};
-
 
-// Delete of an element from a std container. The Delete of an item is from a random position.
+// Delete of an element from a std container, one at a time from the random 'positions'
+// (randomErasePositions, dataset.h) until it is empty
 template<typename Container>
-void linearErase(Container& container)
+void linearErase(Container& container, const std::vector<Number>& positions)
 {
-    // Possibly O(n) to get initially but we use it for the random number generation
-    //    and it is only done ONCE
-    auto size = container.size();
-    while (false == container.empty())
+    for (auto random_position : positions)
     {
         // force silly linear search to the right position to do a delete
-        Number random_position = randomNumber(0, size -1);
         auto itr = container.begin();
 
         // using hand-wrought 'find' to force linear search to the position
@@ -89,18 +106,36 @@ void linearErase(Container& container)
             ++itr; // silly linear
         }
         container.erase(itr);
-        --size;
     }
+}
 
+// The same positions, the block holding the position is found by walking the block
+// sizes
+void linearErase(NumbersPacked& packed, const std::vector<Number>& positions)
+{
+    for (auto random_position : positions) {
+        packed.eraseAt(random_position);
+    }
 }
 
-// Measure time in milliseconds for linear remove (i.e. "erase") in a std container
+// Memory held per number, measured when all numbers are inserted
+double bytesPerNumber(const NumbersInVector& vector)
+{
+    return vector.empty() ? 0 : double(vector.capacity() * sizeof(Number)) / vector.size();
+}
+
+double bytesPerNumber(const NumbersPacked& packed)
+{
+    return packed.empty() ? 0 : double(packed.bytes()) / packed.size();
+}
+
+// Measure time in nanoseconds for linear remove (i.e. "erase") in a std container
 template<typename Container>
-TimeValue linearRemovePerformance(Container& container)
+TimeValue linearRemovePerformance(Container& container, const std::vector<Number>& positions)
 {
-    g2::StopWatch watch;
-    linearErase(container);
-    auto time = watch.elapsedMs().count();
+    g2::CycleStopWatch watch;
+    linearErase(container, positions);
+    auto time = watch.elapsedNs().count();
     return time;
 }
 
@@ -109,47 +144,48 @@ TimeValue linearRemovePerformance(Container& container)
 
 
 
-void listVsVectorLinearPerformance(size_t nbr_of_randoms)
+// 'cache_mode' is applied before every timed insert and erase (cache_mode.h). Returns the
+// sum of all the timed inserts and erases, in nanoseconds
+TimeValue listVsVectorLinearPerformance(size_t nbr_of_randoms, const CacheMode cache_mode)
 {
-    std::uniform_int_distribution<int> distribution(0, nbr_of_randoms);
-    std::mt19937 engine((unsigned int)time(0)); // Mersenne twister MT19937
-    // alternatively:
-    // std::random_device rd;
-    // std::mt19937 engine(rd()); // Mersenne twister MT19937
-
-    auto generator = std::bind(distribution, engine);
-    // Generate n random values and push to storage
-    NumbersInVector     values(nbr_of_randoms);
-    std::for_each(values.begin(), values.end(), [&](Number& n) {
-        n = generator();
-    });
+    // n random values, generated once and then mapped read-only from datasets/
+    NumbersInDataset    values;
+    openDataset(values, DatasetConfig(), nbr_of_randoms);
+    const std::vector<Number> positions = randomErasePositions(nbr_of_randoms, DatasetConfig().seed);
     TimeValue list_time;
     TimeValue list_delete_time;
     TimeValue vector_time;
     TimeValue vector_delete_time;
+    double vector_bytes = 0; // per number, capacity included
     std::cout << nbr_of_randoms << ",\t" << std::flush;
 #ifdef SERIAL_RUN
     // ---- START SERIAL
     // UNCOMMENT THIS IF YOU want to run concurrent    
      NumbersInList    list;
+     prepareCache(cache_mode, values, list);
      list_time = linearInsertPerformance(values, list);
      NumbersInVector    vector;
+     prepareCache(cache_mode, values, vector);
      vector_time = linearInsertPerformance(values, vector);
+     vector_bytes = bytesPerNumber(vector);
      // Random delete
-     list_delete_time = linearRemovePerformance(list);
-     vector_delete_time = linearRemovePerformance(vector);
+     prepareCache(cache_mode, list);
+     list_delete_time = linearRemovePerformance(list, positions);
+     prepareCache(cache_mode, vector);
+     vector_delete_time = linearRemovePerformance(vector, positions);
 // --- STOP SERIAL
 #else     
 // ---- START UNCOMMENT in case you do not have std::thread
 // ---- or want more "exact" measurements. Running some jobs in parallell
 // ---- can create some unwanted side effects which is espacially seen 
-// ---- for low numbers
+// ---- for low numbers. The cache mode is not applied to the list here, the
+// ---- threads share the caches
     // Insert to list and erase from list are the time consuming operations
     // Splitting them into concurrent tasks will speed up the total execution time
-    // 1. Random Insert into list,. possibley done in another thread, copying 'values'
-    // so that if possible avoid false sharing
+    // 1. Random Insert into list,. possibly done in another thread. Both threads read
+    // the same read-only mapping of 'values', nothing is copied
     NumbersInList      list;
-    auto future_list_time = std::async([=, &list]()->TimeValue {return linearInsertPerformance(values, list);});
+    auto future_list_time = std::async([&values, &list]()->TimeValue {return linearInsertPerformance(values, list);});
 
     // Random delete from list,. possibly done in another thread
     NumbersInList list_to_delete; // 1. create the list to delete
@@ -159,13 +195,16 @@ void listVsVectorLinearPerformance(size_t nbr_of_randoms)
     });
     // then empty the list
     auto future_list_delete_time = std::async(
-                                       [&]()->TimeValue {return  linearRemovePerformance(list_to_delete);});
+                                       [&]()->TimeValue {return  linearRemovePerformance(list_to_delete, positions);});
 
 
     // Faster operations: Random Insert/Erase of items to/from Vector, done in foreground
     NumbersInVector    vector;
-    vector_time = linearInsertPerformance(std::cref(values), vector);
-    vector_delete_time = linearRemovePerformance(vector);
+    prepareCache(cache_mode, values, vector);
+    vector_time = linearInsertPerformance(values, vector);
+    vector_bytes = bytesPerNumber(vector);
+    prepareCache(cache_mode, vector);
+    vector_delete_time = linearRemovePerformance(vector, positions);
 
 
     list_time = future_list_time.get(); // sync with the list insert
@@ -174,9 +213,49 @@ void listVsVectorLinearPerformance(size_t nbr_of_randoms)
 // ---- end parallell running
 // ----
 #endif
-    
-    std::cout <<  list_time << ", " << vector_time << ",";
-    std::cout << "\t\t" << list_delete_time << ", " << vector_delete_time << std::endl << std::flush;
+
+    // Small vector: at small N allocation and regrowth dominate, not the search
+    bool run_small_vector = (nbr_of_randoms <= kSmallVectorMaxElements);
+    TimeValue small_vector_time = 0;
+    TimeValue small_vector_delete_time = 0;
+    if (run_small_vector)
+    {
+        NumbersInSmallVector small_vector;
+        prepareCache(cache_mode, values, small_vector);
+        small_vector_time = linearInsertPerformance(values, small_vector);
+        prepareCache(cache_mode, small_vector);
+        small_vector_delete_time = linearRemovePerformance(small_vector, positions);
+    }
+
+    // Packed numbers: a quarter of the vector's bytes or less to read per search
+    NumbersPacked packed;
+    prepareCache(cache_mode, values, packed);
+    TimeValue packed_time = linearInsertPerformance(values, packed);
+    const double packed_bytes = bytesPerNumber(packed);
+    prepareCache(cache_mode, packed);
+    TimeValue packed_delete_time = linearRemovePerformance(packed, positions);
+
+    std::cout <<  list_time << ", " << vector_time << ", ";
+    if (run_small_vector) {
+        std::cout << small_vector_time;
+    } else {
+        std::cout << "-";
+    }
+    std::cout << ", " << packed_time;
+    std::cout << "\t\t" << list_delete_time << ", " << vector_delete_time << ", ";
+    if (run_small_vector) {
+        std::cout << small_vector_delete_time;
+    } else {
+        std::cout << "-";
+    }
+    std::cout << ", " << packed_delete_time;
+    const std::streamsize precision = std::cout.precision();
+    std::cout << "\t\t" << std::fixed << std::setprecision(2) << vector_bytes << ", " << packed_bytes;
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout.precision(precision);
+    std::cout << std::endl << std::flush;
+    return list_time + vector_time + small_vector_time + packed_time
+         + list_delete_time + vector_delete_time + small_vector_delete_time + packed_delete_time;
 }
 
 
@@ -0,0 +1,250 @@
+#ifndef LRU_CACHE_H_
+#define LRU_CACHE_H_
+
+// Fixed capacity caches that evict the least recently used entry, or an approximation
+// of it. The most common use of a linked list: the recency order.
+//
+//   ListLruCache    the classic: a std::list in recency order, an std::unordered_map
+//                   from the key to the list node. A hit splices the node to the
+//                   front, a miss pops the back. A node per entry plus a node per key
+//   ArrayLruCache   the same doubly linked recency order, but the links are 32-bit
+//                   indexes into one array of entries that is allocated up front. The
+//                   key to index map is an OpenAddressingMap, no allocation at all
+//                   after the cache is full
+//   ClockCache      CLOCK, the LRU approximation of operating systems: the entries in
+//                   a ring with a referenced bit. A hit only sets the bit, a miss moves
+//                   the hand around the ring, clears the bits it passes and evicts the
+//                   first entry that was not referenced. A new entry starts
+//                   unreferenced, a key that is never hit again is the first to go
+//
+// lookup(key) marks the entry as used and gives its value, nullptr on a miss. After a
+// miss insert(key, value) adds the key, which must not be in the cache, and evicts an
+// entry when the cache is full. The capacity is > 0. begin() and end() are the entries
+// in storage order, for the warm mode of prepareCache. The key index is out of reach
+// for clflush, that mode sweeps the caches instead (cache_mode.h).
+// Include "open_addressing_map.h" before this file.
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+
+
+template<typename Key, typename Value>
+class ListLruCache
+{
+  typedef std::list<std::pair<Key, Value>> Order;
+
+  Order order_;   // most recently used first
+  std::unordered_map<Key, typename Order::iterator> index_;
+  size_t capacity_;
+
+public:
+  typedef Value value_type;
+  typedef typename Order::const_iterator const_iterator;
+
+  explicit ListLruCache(size_t capacity) : capacity_(capacity) {}
+
+  ListLruCache(const ListLruCache&) = delete;
+  ListLruCache& operator=(const ListLruCache&) = delete;
+
+  const_iterator begin() const { return order_.begin(); }
+  const_iterator end() const   { return order_.end(); }
+
+  size_t size() const     { return index_.size(); }
+  size_t capacity() const { return capacity_; }
+
+  const Value* lookup(const Key& key)
+  {
+    auto itr = index_.find(key);
+    if (itr == index_.end()) {
+      return nullptr;
+    }
+    order_.splice(order_.begin(), order_, itr->second);
+    return &itr->second->second;
+  }
+
+  void insert(const Key& key, const Value& value)
+  {
+    if (index_.size() == capacity_)
+    {
+      index_.erase(order_.back().first);
+      order_.pop_back();
+    }
+    order_.push_front(std::make_pair(key, value));
+    index_[key] = order_.begin();
+  }
+};
+
+
+template<typename Key, typename Value>
+class ArrayLruCache
+{
+  static const uint32_t kNone = 0xFFFFFFFF;
+
+  struct Entry
+  {
+    Key key;
+    uint32_t prev;  // towards the most recently used
+    uint32_t next;  // towards the least recently used
+    Value value;
+  };
+
+  std::vector<Entry> entries_;   // never reallocated, reserved up front
+  OpenAddressingMap<Key, uint32_t> index_;
+  uint32_t head_;  // most recently used
+  uint32_t tail_;  // least recently used
+  size_t capacity_;
+
+  void unlink(const uint32_t at)
+  {
+    Entry& entry = entries_[at];
+    if (kNone == entry.prev) {
+      head_ = entry.next;
+    } else {
+      entries_[entry.prev].next = entry.next;
+    }
+    if (kNone == entry.next) {
+      tail_ = entry.prev;
+    } else {
+      entries_[entry.next].prev = entry.prev;
+    }
+  }
+
+  void pushFront(const uint32_t at)
+  {
+    Entry& entry = entries_[at];
+    entry.prev = kNone;
+    entry.next = head_;
+    if (kNone == head_) {
+      tail_ = at;
+    } else {
+      entries_[head_].prev = at;
+    }
+    head_ = at;
+  }
+
+public:
+  typedef Value value_type;
+  typedef typename std::vector<Entry>::const_iterator const_iterator;
+
+  explicit ArrayLruCache(size_t capacity) : head_(kNone), tail_(kNone), capacity_(capacity)
+  {
+    entries_.reserve(capacity);
+  }
+
+  ArrayLruCache(const ArrayLruCache&) = delete;
+  ArrayLruCache& operator=(const ArrayLruCache&) = delete;
+
+  const_iterator begin() const { return entries_.begin(); }
+  const_iterator end() const   { return entries_.end(); }
+
+  size_t size() const     { return entries_.size(); }
+  size_t capacity() const { return capacity_; }
+
+  const Value* lookup(const Key& key)
+  {
+    const uint32_t* at = index_.find(key);
+    if (nullptr == at) {
+      return nullptr;
+    }
+    if (*at != head_)
+    {
+      unlink(*at);
+      pushFront(*at);
+    }
+    return &entries_[*at].value;
+  }
+
+  void insert(const Key& key, const Value& value)
+  {
+    uint32_t at = tail_;
+    if (entries_.size() < capacity_)
+    {
+      at = uint32_t(entries_.size());
+      entries_.push_back(Entry());
+    }
+    else
+    {
+      index_.erase(entries_[at].key);
+      unlink(at);
+    }
+    entries_[at].key = key;
+    entries_[at].value = value;
+    index_.insert(key, at);
+    pushFront(at);
+  }
+};
+
+
+template<typename Key, typename Value>
+class ClockCache
+{
+  struct Slot
+  {
+    Key key;
+    bool referenced;
+    Value value;
+  };
+
+  std::vector<Slot> slots_;   // the ring, filled up to the capacity
+  OpenAddressingMap<Key, uint32_t> index_;
+  size_t hand_;
+  size_t capacity_;
+
+public:
+  typedef Value value_type;
+  typedef typename std::vector<Slot>::const_iterator const_iterator;
+
+  explicit ClockCache(size_t capacity) : hand_(0), capacity_(capacity)
+  {
+    slots_.reserve(capacity);
+  }
+
+  ClockCache(const ClockCache&) = delete;
+  ClockCache& operator=(const ClockCache&) = delete;
+
+  const_iterator begin() const { return slots_.begin(); }
+  const_iterator end() const   { return slots_.end(); }
+
+  size_t size() const     { return slots_.size(); }
+  size_t capacity() const { return capacity_; }
+
+  const Value* lookup(const Key& key)
+  {
+    const uint32_t* at = index_.find(key);
+    if (nullptr == at) {
+      return nullptr;
+    }
+    slots_[*at].referenced = true;
+    return &slots_[*at].value;
+  }
+
+  void insert(const Key& key, const Value& value)
+  {
+    size_t at = slots_.size();
+    if (slots_.size() < capacity_)
+    {
+      slots_.push_back(Slot());
+    }
+    else
+    {
+      while (slots_[hand_].referenced)
+      {
+        slots_[hand_].referenced = false;
+        hand_ = (hand_ + 1 == capacity_) ? 0 : hand_ + 1;
+      }
+      at = hand_;
+      hand_ = (hand_ + 1 == capacity_) ? 0 : hand_ + 1;
+      index_.erase(slots_[at].key);
+    }
+    slots_[at].key = key;
+    slots_[at].referenced = false;
+    slots_[at].value = value;
+    index_.insert(key, uint32_t(at));
+  }
+};
+
+#endif // LRU_CACHE_H_
@@ -0,0 +1,84 @@
+#ifndef LRU_PERFORMANCE_H_
+#define LRU_PERFORMANCE_H_
+
+// The LRU caches of lru_cache.h under an access trace with a given hit rate. The
+// cached value is a POD record keyed on a[0]. A miss "loads" the record, i.e. makes it
+// from the key, and inserts it.
+//
+// The trace (lruTrace) is seeded, every cache gets the very same accesses. About
+// 'hit_percent' % of them go to a hot set of a quarter of the capacity, the rest are
+// keys that were never seen before. The hot set is loaded before the timed region, so
+// a hot key stays in the cache and the hit rate is close to 'hit_percent' for every
+// cache: the difference in time is the bookkeeping, not the policy. The hit rate each
+// cache achieved is printed next to its time (lruHitRate).
+// Include "pod_performance.h", "kv_performance.h" (touchValue) and "lru_cache.h" before
+// this file.
+
+#include <vector>
+#include <random>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+
+std::vector<Number> lruTrace(const size_t capacity, const size_t nbr_of_accesses,
+                             const size_t hit_percent, const uint64_t seed)
+{
+  const Number hot_keys = Number(std::max(size_t(1), capacity / 4));
+  std::mt19937 engine(static_cast<std::mt19937::result_type>(seed));
+  std::uniform_int_distribution<Number> hot(0, hot_keys - 1);
+  std::uniform_int_distribution<size_t> percent(0, 99);
+  Number next_cold = hot_keys;
+  std::vector<Number> trace(nbr_of_accesses);
+  for (auto& key : trace) {
+    key = (percent(engine) < hit_percent) ? hot(engine) : next_cold++;
+  }
+  return trace;
+}
+
+// The record of a key that was not in the cache
+template<typename Value>
+Value loadRecord(const Number key)
+{
+  Value value = Value();
+  value.a[0] = key;
+  return value;
+}
+
+// One access, the value is loaded and inserted on a miss. A hit is counted in 'hits'
+template<typename Cache>
+Number lruAccess(Cache& cache, const Number key, size_t& hits)
+{
+  typedef typename Cache::value_type Value;
+  const Value* value = cache.lookup(key);
+  if (nullptr == value)
+  {
+    cache.insert(key, loadRecord<Value>(key));
+    return 0;
+  }
+  ++hits;
+  return touchValue(value);
+}
+
+// Load the hot set of lruTrace, before the timed region
+template<typename Cache>
+void lruWarmUp(Cache& cache)
+{
+  const Number hot_keys = Number(std::max(size_t(1), cache.capacity() / 4));
+  size_t hits = 0;
+  for (Number key = 0; key != hot_keys; ++key) {
+    lruAccess(cache, key, hits);
+  }
+}
+
+// The achieved hit rate, e.g. "hits 74.8%"
+std::string lruHitRate(const size_t hits, const size_t nbr_of_accesses)
+{
+  std::ostringstream rate;
+  rate << "hits " << std::fixed << std::setprecision(1);
+  rate << ((0 == nbr_of_accesses) ? 0.0 : 100.0 * double(hits) / double(nbr_of_accesses)) << "%";
+  return rate.str();
+}
+
+#endif // LRU_PERFORMANCE_H_
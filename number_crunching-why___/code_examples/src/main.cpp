@@ -1,6 +1,15 @@
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
 #include "g2_chrono.h"
 #include "linear_performance.h"
+#include "heap_aging.h"
+#include "memory_probe.h"
+#include "stream_ingest.h"
 
 
 // from  Wikipedia C++11 Random 
@@ -8,8 +17,182 @@
 // more details at http://www.codeguru.com/cpp/cpp/cpp_mfc/stl/article.php/c15319
 
 
+// The input as text, one number per line, to feed --stream from a file or a pipe
+void writeInput(const size_t nbr_of_randoms, std::ostream& out)
+{
+  NumbersInDataset values;
+  openDataset(values, DatasetConfig(), nbr_of_randoms);
+  for (auto& n : values) {
+    out << n << '\n';
+  }
+  out << std::flush;
+}
+
+template<typename Container>
+int streamInto(std::istream& in, const std::string& name, const size_t chunk_size)
+{
+  Container container;
+  printStreamReport(streamIngest(in, container, chunk_size), name, std::cout);
+  return 0;
+}
+
+// The element counts of the comparison when no --sizes is given: the small rows, then
+// 50000 to 500000 in steps of 50000
+std::vector<size_t> defaultSizes()
+{
+  std::vector<size_t> sizes = {10, 100, 1000, 5000, 10000, 20000, 40000};
+  for (size_t cnt = 50000; cnt <= 500000; cnt += 50000) {
+    sizes.push_back(cnt);
+  }
+  return sizes;
+}
+
+struct MainOptions
+{
+  std::string stream;          // file or "-", the streaming mode when set
+  std::string container;
+  size_t chunk_size;
+  size_t write_input;
+  std::vector<size_t> sizes;   // rows of the comparison, ascending
+  long long budget_ms;         // per row of the comparison, 0 is no limit
+  CacheMode cache_mode;        // before every timed insert and erase of the comparison
+  std::vector<HeapState> heap_states; // every row of the comparison is run once per state
+
+  MainOptions() : container("vector"), chunk_size(4096), write_input(0), sizes(defaultSizes()), budget_ms(0)
+                , cache_mode(CacheMode::kAsIs), heap_states(1, HeapState::kFresh) {}
+};
+
+void printUsage(const char* program)
+{
+  std::cerr << "Usage: " << program << " [--sizes=a,b,c] [--budget-ms=N] [--cache=as-is|warm|cold|clflush]"
+            << " [--heap=fresh,aged]" << std::endl;
+  std::cerr << "       " << program << " --write-input=N" << std::endl;
+  std::cerr << "       " << program << " --stream=file|- [--container=list|vector|packed] [--chunk=N]" << std::endl;
+}
+
+// false on an unknown argument or a bad value
+bool parseArguments(int argc, char** argv, MainOptions& options)
+{
+  for (int idx = 1; idx < argc; ++idx)
+  {
+    const std::string arg = argv[idx];
+    const size_t equal = arg.find('=');
+    const std::string key = arg.substr(0, equal);
+    const std::string value = (equal == std::string::npos) ? "" : arg.substr(equal + 1);
+    std::istringstream number(value);
+    bool ok = true;
+    if ("--stream" == key) {
+      options.stream = value;
+      ok = !value.empty();
+    } else if ("--container" == key) {
+      options.container = value;
+    } else if ("--chunk" == key) {
+      ok = (number >> options.chunk_size) && options.chunk_size > 0;
+    } else if ("--write-input" == key) {
+      ok = (number >> options.write_input) && options.write_input > 0;
+    } else if ("--cache" == key) {
+      ok = parseCacheMode(value, options.cache_mode);
+    } else if ("--heap" == key) {
+      options.heap_states.clear();
+      std::string part;
+      while (ok && std::getline(number, part, ','))
+      {
+        HeapState state;
+        ok = parseHeapState(part, state);
+        options.heap_states.push_back(state);
+      }
+      ok = ok && !options.heap_states.empty();
+    } else if ("--budget-ms" == key) {
+      ok = (number >> options.budget_ms) && options.budget_ms >= 0;
+    } else if ("--sizes" == key) {
+      options.sizes.clear();
+      std::string part;
+      while (ok && std::getline(number, part, ','))
+      {
+        std::istringstream size(part);
+        size_t nbr_of_randoms = 0;
+        ok = (size >> nbr_of_randoms) && nbr_of_randoms > 0;
+        options.sizes.push_back(nbr_of_randoms);
+      }
+      std::sort(options.sizes.begin(), options.sizes.end());
+      ok = ok && !options.sizes.empty();
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Streaming mode (stream_ingest.h) instead of the comparison below:
+//   list_vs_vector --write-input=N > numbers.txt
+//   list_vs_vector --stream=numbers.txt [--container=list|vector|packed] [--chunk=N]
+//   list_vs_vector --write-input=N | list_vs_vector --stream=-
+int streamingMode(const MainOptions& options)
+{
+  if (options.write_input > 0) {
+    writeInput(options.write_input, std::cout);
+    return 0;
+  }
+
+  std::ifstream file;
+  if ("-" != options.stream) {
+    file.open(options.stream.c_str(), std::ios::binary);
+    if (!file) {
+      std::cerr << "Cannot read " << options.stream << std::endl;
+      return 1;
+    }
+  }
+  std::istream& in = ("-" == options.stream) ? std::cin : file;
+  if ("list" == options.container) {
+    return streamInto<NumbersInList>(in, options.container, options.chunk_size);
+  } else if ("vector" == options.container) {
+    return streamInto<NumbersInVector>(in, options.container, options.chunk_size);
+  } else if ("packed" == options.container) {
+    return streamInto<NumbersPacked>(in, options.container, options.chunk_size);
+  }
+  std::cerr << "Unknown container: " << options.container << std::endl;
+  return 1;
+}
+
+// One row of the comparison, on a fresh heap or with an AgedHeap alive around it
+// (heap_aging.h): the list nodes are then allocated from a scattered heap. Returns the
+// timed nanoseconds of the row
+TimeValue linearPerformanceOnHeap(const size_t nbr_of_randoms, const CacheMode cache_mode, const HeapState heap_state)
+{
+  std::unique_ptr<AgedHeap> aged;
+  if (HeapState::kAged == heap_state) {
+    aged.reset(new AgedHeap(HeapAgingConfig()));
+  }
+  return listVsVectorLinearPerformance(nbr_of_randoms, cache_mode);
+}
+
+// The list's linear search makes the timed inserts and erases of a row O(n^2): they
+// are scaled by the square of the size ratio. The rest of the previous row, e.g.
+// opening the dataset, is taken as it is, it dominates the small rows. In microseconds,
+// the small rows take less than a ms
+double predictRowUs(const TimeValue previous_us, const TimeValue previous_timed_us,
+                    const size_t previous_size, const size_t nbr_of_randoms)
+{
+  const double ratio = double(nbr_of_randoms) / double(previous_size);
+  const double untimed_us = double(std::max(TimeValue(0), previous_us - previous_timed_us));
+  return untimed_us + double(previous_timed_us) * ratio * ratio;
+}
+
+
 int main(int argc, char** argv)
 { 
+  MainOptions options;
+  if (!parseArguments(argc, argv, options)) {
+    printUsage(argv[0]);
+    return 1;
+  }
+  if (!options.stream.empty() || options.write_input > 0) {
+    return streamingMode(options);
+  }
+
 
   // Generate N random integers and insert them in its proper position in the numerical order using
   // LINEAR search
@@ -27,28 +210,61 @@ int main(int argc, char** argv)
   std::cout << "\nFor test results on Windows and Linux please go to: " << std::endl;
   std::cout << "https://docs.google.com/spreadsheet/pub?key=0AkliMT3ZybjAdGJMU1g5Q0QxWEluWGRzRnZKZjNMMGc&output=html" << std::endl;
 
-  std::cout << "\n\n********** Times in milliseconds **********" << std::endl;
+  g2::cyclesPerNs(); // calibrate the TSC before anything is measured
+  std::cout << "\n\n********** Times in nanoseconds **********" << std::endl;
+  std::cout << "(time stamp counter at " << g2::cyclesPerNs() << " cycles/ns, calibrated against steady_clock)" << std::endl;
+  std::cout << "(input read from " << DatasetConfig().directory << "/ with seed " << DatasetConfig().seed;
+  std::cout << ", the same numbers on every run)" << std::endl;
+  std::cout << "(cache before every timed insert and erase: " << cacheModeName(options.cache_mode) << ", see cache_mode.h)" << std::endl;
+  const bool only_fresh = (1 == options.heap_states.size() && HeapState::kFresh == options.heap_states[0]);
+  if (!only_fresh)
+  {
+    std::cout << "(heap:";
+    for (auto heap_state : options.heap_states) {
+      std::cout << " " << heapStateName(heap_state);
+    }
+    std::cout << ", every row starts with its heap state, see heap_aging.h)" << std::endl;
+  }
+  printMemoryProfile(probeMemory(), std::cout);
   g2::StopWatch watch;
   // Generate N random integers and insert them in its proper position in the numerical order using
   // LINEAR search
-  std::cout << "[elements, linear add time [ms] [list, vector],    linear erase time[ms] [list, vector]" << std::endl;
-  listVsVectorLinearPerformance(10);
-  listVsVectorLinearPerformance(100);
-  listVsVectorLinearPerformance(1000);
-  listVsVectorLinearPerformance(10000);
-  listVsVectorLinearPerformance(20000);  
-  listVsVectorLinearPerformance(40000);
-  size_t cnt = 50000;
-  g2::StopWatch w2;
-  do{
-    w2.restart();
-    listVsVectorLinearPerformance(cnt);
-    auto t = w2.elapsedMs().count(); 
-    std::cout << cnt << " items took " << t/1000 << " seconds or ";
-    std::cout << t/ 60000  << " minutes\n" << std::endl;
-    cnt+=50000; 
-  }
-  while(cnt <= 500000); 
+  std::cout << "[elements, linear add time [ns] [list, vector, small_vector, packed],    linear erase time[ns] [list, vector, small_vector, packed],";
+  std::cout << "    bytes per number [vector, packed]" << std::endl;
+  std::cout << "(packed: sorted delta encoded and bit packed blocks of " << NumbersPacked::kBlockCapacity << " numbers)" << std::endl;
+  std::cout << "(small_vector keeps " << kSmallVectorInlineCapacity << " elements in-place and is only run up to ";
+  std::cout << kSmallVectorMaxElements << " elements, '-' means not run)" << std::endl;
+  g2::StopWatch row_watch;
+  size_t previous_size = 0;
+  TimeValue previous_us = 0;
+  TimeValue previous_timed_us = 0;
+  for (auto nbr_of_randoms : options.sizes)
+  {
+    if (options.budget_ms > 0 && previous_size > 0
+        && predictRowUs(previous_us, previous_timed_us, previous_size, nbr_of_randoms) > 1000.0 * double(options.budget_ms))
+    {
+      std::cout << "Skipped from " << nbr_of_randoms << " elements: a row is predicted to take more than ";
+      std::cout << options.budget_ms << " ms (--budget-ms)" << std::endl;
+      break;
+    }
+    row_watch.restart();
+    TimeValue timed_ns = 0;
+    for (auto heap_state : options.heap_states)
+    {
+      if (!only_fresh) {
+        std::cout << heapStateName(heap_state) << ",\t";
+      }
+      timed_ns += linearPerformanceOnHeap(nbr_of_randoms, options.cache_mode, heap_state);
+    }
+    previous_us = row_watch.elapsedUs().count();
+    previous_timed_us = timed_ns / 1000;
+    previous_size = nbr_of_randoms;
+    if (nbr_of_randoms >= 50000)
+    {
+      std::cout << nbr_of_randoms << " items took " << previous_us/1000000 << " seconds or ";
+      std::cout << previous_us/60000000 << " minutes\n" << std::endl;
+    }
+  }
   auto total_time_ms = watch.elapsedMs().count();
 
   std::cout << "Exiting test,. the whole measuring took " << total_time_ms << "ms";
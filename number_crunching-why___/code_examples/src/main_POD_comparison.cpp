@@ -1,6 +1,8 @@
 #include <list>
 #include <vector>
 #include <deque>
+#include <map>
+#include <unordered_map>
 #include <iostream>
 #include <iomanip>
 #include <future>
@@ -15,197 +17,580 @@
 #include <cassert>
 
 
-namespace g2
+#include "g2_chrono.h"
+#include "pod_performance.h"
+#include "element_types.h"
+#include "latency_histogram.h"
+#include "cache_mode.h"
+#include "heap_aging.h"
+#include "dataset.h"
+#include "fork_isolation.h"
+#include "baseline.h"
+#include "flat_map.h"
+#include "open_addressing_map.h"
+#include "kv_performance.h"
+#include "unrolled_list.h"
+#include "block_deque.h"
+#include "counted_btree.h"
+#include "rank_performance.h"
+#include "search_btree.h"
+#include "batched_lookup.h"
+#include "sorted_layouts.h"
+#include "layout_lookup.h"
+#include "lru_cache.h"
+#include "lru_performance.h"
+#include "run_merge_sort.h"
+#include "record_sort.h"
+#include "memory_probe.h"
+#include "benchmark_matrix.h"
+#include "benchmark_runner.h"
+
+// =================
+// The benchmark matrix: workloads x POD sizes x containers.
+// Each list below can be extended with one line, every combination then
+// becomes a named cell that can be picked with the filter argument
+// =================
+
+// Containers
+struct StdList   { template<typename T> using Of = std::list<T>;   static const char* name() { return "list"; } };
+struct StdVector { template<typename T> using Of = std::vector<T>; static const char* name() { return "vector"; } };
+struct StdDeque  { template<typename T> using Of = std::deque<T>;  static const char* name() { return "deque"; } };
+
+// Unrolled linked list with 1KB nodes, i.e. 16 cache lines of elements per node
+struct Unrolled  { template<typename T> using Of = UnrolledList<T, UnrolledNodeCapacity<T, 1024>::value>;
+                   static const char* name() { return "unrolled_list"; } };
+
+// Deques with the block size fitted to the records, compare std::deque that has 512
+// byte blocks on libstdc++, i.e. 2 elements of POD<64>. See block_deque.h
+struct BlockDeque1K { template<typename T> using Of = BlockDeque<T, 1024>;
+                      static const char* name() { return "block_deque_1k"; } };
+struct BlockDeque4K { template<typename T> using Of = BlockDeque<T, 4096>;
+                      static const char* name() { return "block_deque_4k"; } };
+
+// Order statistic B+tree with 1KB leaves, see counted_btree.h
+struct CountedTree { template<typename T> using Of = CountedBTree<T, UnrolledNodeCapacity<T, 1024>::value>;
+                     static const char* name() { return "counted_btree"; } };
+
+// Static B+tree searched on the POD key a[0], see search_btree.h
+struct SearchTree  { template<typename T> using Of = SearchBTree<Number, T>;
+                     static const char* name() { return "search_btree"; } };
+
+// Vectors that sortContainer sorts through (key, index) pairs or with a radix sort,
+// see record_sort.h. Compare the vector where the records themselves are sorted
+struct KeyIndexSort { template<typename T> using Of = KeyIndexVector<T>;
+                      static const char* name() { return "key_index_sort"; } };
+struct RadixSort    { template<typename T> using Of = RadixVector<T>;
+                      static const char* name() { return "radix_sort"; } };
+// Stable sorts for presorted input (--input=ascending,nearly_sorted,...), std::stable_sort
+// and the run-adaptive merge sort of run_merge_sort.h
+struct StableSort   { template<typename T> using Of = StableSortVector<T>;
+                      static const char* name() { return "stable_sort"; } };
+struct RunMergeSort { template<typename T> using Of = RunMergeVector<T>;
+                      static const char* name() { return "run_merge_sort"; } };
+
+// LRU caches of the POD records on the key a[0], see lru_cache.h
+struct ListLru  { template<typename T> using Of = ListLruCache<Number, T>;  static const char* name() { return "list_lru"; } };
+struct ArrayLru { template<typename T> using Of = ArrayLruCache<Number, T>; static const char* name() { return "array_lru"; } };
+struct Clock    { template<typename T> using Of = ClockCache<Number, T>;    static const char* name() { return "clock"; } };
+
+// Build-once layouts of the sorted keys, see sorted_layouts.h
+struct Eytzinger   { template<typename T> using Of = EytzingerArray<Number, T>;
+                     static const char* name() { return "eytzinger"; } };
+struct Veb         { template<typename T> using Of = VebArray<Number, T>;
+                     static const char* name() { return "veb"; } };
+
+// Maps for the key-value workloads, keyed on the POD key a[0]
+struct FlatSortedMap   { template<typename T> using Of = FlatMap<Number, T>;            static const char* name() { return "flat_map"; } };
+struct StdMap          { template<typename T> using Of = std::map<Number, T>;           static const char* name() { return "map"; } };
+struct StdUnorderedMap { template<typename T> using Of = std::unordered_map<Number, T>; static const char* name() { return "unordered_map"; } };
+struct OpenAddressing  { template<typename T> using Of = OpenAddressingMap<Number, T>;  static const char* name() { return "open_addressing"; } };
+
+
+// small increments for measuring up to 5000, then step it up till 40.000
+std::vector<size_t> podSweep()
 {
-  typedef std::chrono::high_resolution_clock clock;
-  typedef std::chrono::microseconds microseconds;
-  typedef std::chrono::milliseconds milliseconds;
+  std::vector<size_t> sizes = {100, 200, 400, 800, 1000, 2000, 3000, 4000, 5000};
+  for(size_t cnt = 10000; cnt <= 40000; cnt+=5000)
+  {
+    sizes.push_back(cnt);
+  }
+  return sizes;
+}
+
+// Sort is O(n log n), same sizes as ideone_tLUeK.cpp up to 1.000.000
+std::vector<size_t> sortSweep()
+{
+  std::vector<size_t> sizes = {10, 100, 1000, 10000, 20000, 30000, 40000};
+  for(size_t cnt = 50000; cnt <= 1000000; cnt+=50000)
+  {
+    sizes.push_back(cnt);
+  }
+  return sizes;
+}
 
-  clock::time_point now(){return clock::now();}
+// Insert and erase into the flat map is O(n) per element, like the linear insert
+std::vector<size_t> kvSweep()
+{
+  return {100, 1000, 10000, 20000, 40000};
+}
 
-  microseconds intervalUs(const clock::time_point& t1, const clock::time_point& t0)
-  {return std::chrono::duration_cast<microseconds>(t1 - t0);}
+// Insert and erase at a rank: O(n) for the vector's memmove, O(log n) for the counted
+// B+tree, the large sizes show where the tree overtakes
+std::vector<size_t> rankSweep()
+{
+  return {1000, 5000, 10000, 50000, 100000, 200000};
+}
 
-  milliseconds intervalMs(const clock::time_point& t1,const clock::time_point& t0)
-  {return std::chrono::duration_cast<milliseconds>(t1 - t0);}
+// Lookups and iteration on a map that was built up front
+std::vector<size_t> kvLookupSweep()
+{
+  return {100, 1000, 10000, 100000, 1000000};
+}
 
+// Batched lookups: a fixed number of lookups, the size is what they search through
+std::vector<size_t> batchedLookupSweep()
+{
+  return {1000, 10000, 100000, 1000000};
+}
 
-  class StopWatch
+// LRU caches: the size is the capacity, the trace has kLruAccessesPerEntry accesses
+// per entry of the capacity
+std::vector<size_t> lruSweep()
+{
+  return {1000, 10000, 100000, 1000000};
+}
+const size_t kLruAccessesPerEntry = 4;
+
+// The owning element types are much slower to shift, the sweep stops at 10000
+std::vector<size_t> elementSweep()
+{
+  return {100, 1000, 2000, 5000, 10000};
+}
+
+
+// Workloads. Each one sets up its containers once in 'measure', TimedWorkload makes
+// 'run' and 'record' of it (benchmark_matrix.h)
+struct LinearInsert : TimedWorkload<LinearInsert>
+{
+  static const char* name() { return "linear_insert"; }
+  static std::vector<size_t> sweep() { return podSweep(); }
+
+  template<typename Container, Number Size, typename Timing>
+  static TimeValue measure(const size_t nbr_of_randoms, const RunContext& context, Timing& timing)
   {
-    clock::time_point start_;
-  public:
-    StopWatch() : start_(clock::now()){}
-    clock::time_point restart()         { start_ = clock::now(); return start_;}
-    microseconds elapsedUs()            { return intervalUs(now(), start_);}
-    milliseconds elapsedMs()            {return intervalMs(now(), start_);}
-  };
-} // g2
+    typedef typename Container::template Of<POD<Size>> Storage;
+    MappedDataset<POD<Size>> values;
+    openDataset(values, context.dataset, nbr_of_randoms);
+    Storage storage;
+    prepareCache(context.cache_mode, values, storage);
+    return timing.each(values, [&](const POD<Size>& n) { linearInsertOne(n, storage); });
+  }
+};
 
-typedef unsigned int  Number;
-typedef long long int            TimeValue;
-const std::string rows_explained = "elements         list_time   vector_time   deque_time ";
+struct LinearErase : TimedWorkload<LinearErase>
+{
+  static const char* name() { return "linear_erase"; }
+  static std::vector<size_t> sweep() { return podSweep(); }
 
+  template<typename Container, Number Size, typename Timing>
+  static TimeValue measure(const size_t nbr_of_randoms, const RunContext& context, Timing& timing)
+  {
+    typedef typename Container::template Of<POD<Size>> Storage;
+    MappedDataset<POD<Size>> values;
+    openDataset(values, context.dataset, nbr_of_randoms);
+    Storage storage(values.begin(), values.end());
+    const std::vector<Number> positions = randomErasePositions(nbr_of_randoms, context.dataset.seed);
+    prepareCache(context.cache_mode, values, storage);
+    return timing.each(positions, [&](const Number position) { linearEraseAt(position, storage); });
+  }
+};
 
-// Silly POD to test with variadic POD size
-template<Number Size>
-struct POD
+// Linear insert that remembers the last insert position (ideone_XprUU.cpp)
+struct LinearSmartInsert : TimedWorkload<LinearSmartInsert>
 {
-   Number a[Size];
+  static const char* name() { return "linear_smart_insert"; }
+  static std::vector<size_t> sweep() { return podSweep(); }
 
-  bool operator>=(const POD& b) const
+  template<typename Container, Number Size, typename Timing>
+  static TimeValue measure(const size_t nbr_of_randoms, const RunContext& context, Timing& timing)
   {
-    return (this->a[0] >= b.a[0]);
+    typedef typename Container::template Of<POD<Size>> Storage;
+    MappedDataset<POD<Size>> values;
+    openDataset(values, context.dataset, nbr_of_randoms);
+    Storage storage;
+    SmartInserter<POD<Size>, Storage> inserter(storage);
+    prepareCache(context.cache_mode, values, storage);
+    return timing.each(values, std::ref(inserter));
   }
 };
 
-/* ???? below works on nix but not on windows 2011)
-// Random integer function from http://www2.research.att.com/~bs/C++0xFAQ.html#std-random
-int random_int(int low, int high)
+// Sort the records on the key: std::sort of the records (vector, deque), list::sort,
+// std::stable_sort, and the key-index, radix and run-adaptive merge sorts of
+// record_sort.h. Which is fastest depends on the record size, the sweep runs every POD
+// size, and on how sorted the input already is (--input). A sort is one single operation
+struct Sort : TimedWorkload<Sort>
 {
-  using namespace std;
-  static default_random_engine engine {};
-  typedef uniform_int_distribution<int> Distribution;
-  static Distribution distribution {};
-  return distribution(engine, Distribution::param_type{low, high});
-}
-*/
-
-/*
-// Generate a random number using the 'mersenne twister distribution'
-// http://en.wikipedia.org/wiki/Mersenne_twister
-// Random numbers are chosen within the range limits of 'low' and 'high'
-int random_int(int low, int high)
-{
-    std::uniform_int_distribution<int> distribution(low, high);
-    static std::mt19937 engine((unsigned int)time(0)); // Mersenne twister MT19937
-    auto generator = std::bind(distribution, engine);
-    return generator();
+  static const char* name() { return "sort"; }
+  static std::vector<size_t> sweep() { return sortSweep(); }
+
+  template<typename Container, Number Size, typename Timing>
+  static TimeValue measure(const size_t nbr_of_randoms, const RunContext& context, Timing& timing)
+  {
+    typedef typename Container::template Of<POD<Size>> Storage;
+    MappedDataset<POD<Size>> values;
+    openDataset(values, context.dataset, nbr_of_randoms);
+    Storage storage(values.begin(), values.end());
+    prepareCache(context.cache_mode, values, storage);
+    return timing.times(1, [&]() { sortContainer(storage); });
+  }
+};
+
+// Linear insert of element types that own their payload (element_types.h)
+template<template<Number> class Element>
+struct LinearMoveInsert : TimedWorkload<LinearMoveInsert<Element>>
+{
+  static std::string name() { return std::string("linear_insert_") + Element<1>::name(); }
+  static std::vector<size_t> sweep() { return elementSweep(); }
+
+  template<typename Container, Number Size, typename Timing>
+  static TimeValue measure(const size_t nbr_of_randoms, const RunContext& context, Timing& timing)
+  {
+    typedef typename Container::template Of<Element<Size>> Storage;
+    MappedDataset<POD<Size>> values;
+    openDataset(values, context.dataset, nbr_of_randoms);
+    Storage storage;
+    prepareCache(context.cache_mode, values, storage);
+    return timing.each(values, [&](const POD<Size>& n) { linearMoveInsertOne<Element<Size>>(n, storage); });
+  }
+};
+
+
+// Insert at random ranks into an empty container (rank_performance.h). The vector and
+// deque go directly to the position, list and unrolled list walk to it
+struct RankInsert : TimedWorkload<RankInsert>
+{
+  static const char* name() { return "rank_insert"; }
+  static std::vector<size_t> sweep() { return rankSweep(); }
+
+  template<typename Container, Number Size, typename Timing>
+  static TimeValue measure(const size_t nbr_of_randoms, const RunContext& context, Timing& timing)
+  {
+    typedef typename Container::template Of<POD<Size>> Storage;
+    MappedDataset<POD<Size>> values;
+    openDataset(values, context.dataset, nbr_of_randoms);
+    const std::vector<Number> positions = randomInsertPositions(nbr_of_randoms, context.dataset.seed);
+    Storage storage;
+    size_t idx = 0;
+    prepareCache(context.cache_mode, values, storage);
+    return timing.times(nbr_of_randoms, [&]() { insertAtRank(storage, positions[idx], values[idx]); ++idx; });
+  }
+};
+
+// Erase at random ranks until empty, the same positions as linear_erase
+struct RankErase : TimedWorkload<RankErase>
+{
+  static const char* name() { return "rank_erase"; }
+  static std::vector<size_t> sweep() { return rankSweep(); }
+
+  template<typename Container, Number Size, typename Timing>
+  static TimeValue measure(const size_t nbr_of_randoms, const RunContext& context, Timing& timing)
+  {
+    typedef typename Container::template Of<POD<Size>> Storage;
+    MappedDataset<POD<Size>> values;
+    openDataset(values, context.dataset, nbr_of_randoms);
+    Storage storage(values.begin(), values.end());
+    const std::vector<Number> positions = randomErasePositions(nbr_of_randoms, context.dataset.seed);
+    prepareCache(context.cache_mode, values, storage);
+    return timing.each(positions, [&](const Number position) { eraseAtRank(storage, position); });
+  }
+};
+
+
+// Key-value workloads (kv_performance.h): the POD is the value, a[0] the key
+struct KvInsert : TimedWorkload<KvInsert>
+{
+  static const char* name() { return "kv_insert"; }
+  static std::vector<size_t> sweep() { return kvSweep(); }
+
+  template<typename Container, Number Size, typename Timing>
+  static TimeValue measure(const size_t nbr_of_randoms, const RunContext& context, Timing& timing)
+  {
+    typedef typename Container::template Of<POD<Size>> Storage;
+    MappedDataset<POD<Size>> values;
+    openDataset(values, context.dataset, nbr_of_randoms);
+    Storage map;
+    prepareCache(context.cache_mode, values, map);
+    return timing.each(values, [&](const POD<Size>& n) { kvInsert(map, n); });
+  }
+};
+
+// Every key of the input is looked up once, in input order
+struct KvLookup : TimedWorkload<KvLookup>
+{
+  static const char* name() { return "kv_lookup"; }
+  static std::vector<size_t> sweep() { return kvLookupSweep(); }
+
+  template<typename Container, Number Size, typename Timing>
+  static TimeValue measure(const size_t nbr_of_randoms, const RunContext& context, Timing& timing)
+  {
+    typedef typename Container::template Of<POD<Size>> Storage;
+    MappedDataset<POD<Size>> values;
+    openDataset(values, context.dataset, nbr_of_randoms);
+    Storage map;
+    kvBuild(map, values);
+    prepareCache(context.cache_mode, values, map);
+    Number found = 0;
+    const TimeValue time = timing.each(values, [&](const POD<Size>& n) { found += touchValue(kvFind(map, keyOf(n))); });
+    volatile Number sink = found; // keeps the work from being optimized away
+    (void)sink;
+    return time;
+  }
 };
-*/
-// Random integer function from http://www2.research.att.com/~bs/C++0xFAQ.html#std-random
-int random_int(int low, int high)
-{
-  using namespace std;
-  static default_random_engine engine;
-  typedef uniform_int_distribution<int> Distribution;
-  static Distribution distribution;
-  return distribution(engine, Distribution::param_type(low, high));
-}
 
+struct KvErase : TimedWorkload<KvErase>
+{
+  static const char* name() { return "kv_erase"; }
+  static std::vector<size_t> sweep() { return kvSweep(); }
+
+  template<typename Container, Number Size, typename Timing>
+  static TimeValue measure(const size_t nbr_of_randoms, const RunContext& context, Timing& timing)
+  {
+    typedef typename Container::template Of<POD<Size>> Storage;
+    MappedDataset<POD<Size>> values;
+    openDataset(values, context.dataset, nbr_of_randoms);
+    Storage map;
+    kvBuild(map, values);
+    prepareCache(context.cache_mode, values, map);
+    return timing.each(values, [&](const POD<Size>& n) { kvErase(map, keyOf(n)); });
+  }
+};
+
+// One walk over all entries in key order, the walk is one single operation
+struct KvIterate : TimedWorkload<KvIterate>
+{
+  static const char* name() { return "kv_iterate"; }
+  static std::vector<size_t> sweep() { return kvLookupSweep(); }
 
-// Use a template approach to use functor, function pointer or lambda to insert an
-// element in the input container and return the "time result".
-// Search is LINEAR. Elements are insert in SORTED order
-template<typename ValueType, typename Container>
-void linearInsertion(const std::vector<ValueType>& numbers, Container& container)
-{
-    std::for_each(numbers.begin(), numbers.end(),
-                  [&](const ValueType& n)
-    {
-        auto itr = container.begin();
-        for (; itr!= container.end(); ++itr)
-        {
-            if ((*itr) >= n) {
-                break;
-            }
-        }
-        container.insert(itr, n);
+  template<typename Container, Number Size, typename Timing>
+  static TimeValue measure(const size_t nbr_of_randoms, const RunContext& context, Timing& timing)
+  {
+    typedef typename Container::template Of<POD<Size>> Storage;
+    MappedDataset<POD<Size>> values;
+    openDataset(values, context.dataset, nbr_of_randoms);
+    Storage map;
+    kvBuild(map, values);
+    prepareCache(context.cache_mode, values, map);
+    Number sum = 0;
+    const TimeValue time = timing.times(1, [&]() {
+      kvForEachOrdered(map, [&](const Number key, const POD<Size>& value) { sum += key + touchValue(&value); });
     });
-}
+    volatile Number sink = sum; // keeps the work from being optimized away
+    (void)sink;
+    return time;
+  }
+};
 
-// Measure time in microseconds (us) for linear insert in a std container
-template<typename Container, typename ValueType>
-TimeValue linearInsertPerformance(const std::vector<ValueType>& randoms, Container& container)
+// A lookup table in use: 70% lookups, 20% inserts of new keys and 10% erase, see kvMixedOne
+struct KvMixed : TimedWorkload<KvMixed>
 {
-    g2::StopWatch watch;
-    linearInsertion<ValueType, Container>(std::cref(randoms), container);
-    auto time = watch.elapsedUs().count();
+  static const char* name() { return "kv_mixed"; }
+  static std::vector<size_t> sweep() { return kvSweep(); }
+
+  template<typename Container, Number Size, typename Timing>
+  static TimeValue measure(const size_t nbr_of_randoms, const RunContext& context, Timing& timing)
+  {
+    typedef typename Container::template Of<POD<Size>> Storage;
+    MappedDataset<POD<Size>> values;
+    openDataset(values, context.dataset, nbr_of_randoms);
+    Storage map;
+    kvBuild(map, values);
+    prepareCache(context.cache_mode, values, map);
+    size_t position = 0;
+    Number done = 0;
+    const TimeValue time = timing.each(values, [&](const POD<Size>& n) {
+      done += kvMixedOne(position++, n, Number(nbr_of_randoms), map);
+    });
+    volatile Number sink = done; // keeps the work from being optimized away
+    (void)sink;
     return time;
-}
+  }
+};
+
+
+// Lookups of the keys of the first kBatchedLookups values in a sorted container,
+// 'Width' of them interleaved (batched_lookup.h). A list walk is O(n) per lookup, so
+// the number of lookups is fixed and only the searched size grows. One operation is
+// one batch of 'Width' lookups
+const size_t kBatchedLookups = 1000;
 
-template<Number SizeOfPod>
-void listVsVectorLinearPerformance(const size_t nbr_of_randoms)
+template<size_t Width>
+struct BatchedLookup : TimedWorkload<BatchedLookup<Width>>
 {
-  // Generate n random values and push to storage
-  typedef POD<SizeOfPod> POD_value;
-  std::vector<POD_value> values(nbr_of_randoms);
-  const auto lower_limit = 0;
-  const auto upper_limit = nbr_of_randoms -1;
-  std::for_each(values.begin(), values.end(), [&](POD_value& n) { n.a[0] = random_int(lower_limit, upper_limit);});
+  static std::string name() { return "batched_lookup_" + std::to_string(Width); }
+  static std::vector<size_t> sweep() { return batchedLookupSweep(); }
 
-  TimeValue list_time;
-  TimeValue vector_time;
-  TimeValue deque_time;
-  std::cout << nbr_of_randoms << ",\t" << std::flush;
-  { // force local scope - to clear up the containers at exit
-    std::list<POD_value>      list;
-    list_time = linearInsertPerformance<std::list<POD_value>, POD_value>(values, list);
+  template<typename Container, Number Size, typename Timing>
+  static TimeValue measure(const size_t nbr_of_randoms, const RunContext& context, Timing& timing)
+  {
+    typedef typename Container::template Of<POD<Size>> Storage;
+    MappedDataset<POD<Size>> values;
+    openDataset(values, context.dataset, nbr_of_randoms);
+    const std::vector<POD<Size>> keys(values.begin(), values.begin() + std::min(nbr_of_randoms, kBatchedLookups));
+    Storage storage;
+    buildSorted(values, storage);
+    prepareCache(context.cache_mode, keys, storage);
+    Number found = 0;
+    size_t first = 0;
+    const TimeValue time = timing.times((keys.size() + Width - 1) / Width, [&]() {
+      const size_t last = std::min(keys.size(), first + Width);
+      interleavedLookup<Width>(storage, keys.begin() + first, keys.begin() + last,
+                               [&](const POD<Size>* value) { found += touchValue(value); });
+      first = last;
+    });
+    volatile Number sink = found; // keeps the work from being optimized away
+    (void)sink;
+    return time;
   }
+};
+
+
+// One lookup at a time in a read mostly sorted set, in the layouts of sorted_layouts.h
+// compared with std::lower_bound on the sorted vector and a list walk. The same fixed
+// number of lookups as the batched lookups
+struct LayoutLookup : TimedWorkload<LayoutLookup>
+{
+  static const char* name() { return "layout_lookup"; }
+  static std::vector<size_t> sweep() { return batchedLookupSweep(); }
+
+  template<typename Container, Number Size, typename Timing>
+  static TimeValue measure(const size_t nbr_of_randoms, const RunContext& context, Timing& timing)
   {
-    std::vector<POD_value>    vector;
-    vector_time = linearInsertPerformance<std::vector<POD_value>, POD_value>(values, vector);
+    typedef typename Container::template Of<POD<Size>> Storage;
+    MappedDataset<POD<Size>> values;
+    openDataset(values, context.dataset, nbr_of_randoms);
+    const std::vector<POD<Size>> keys(values.begin(), values.begin() + std::min(nbr_of_randoms, kBatchedLookups));
+    Storage storage;
+    buildSorted(values, storage);
+    prepareCache(context.cache_mode, keys, storage);
+    Number found = 0;
+    const TimeValue time = timing.each(keys, [&](const POD<Size>& n) {
+      found += touchValue(sortedLookup(storage, keyOf(n)));
+    });
+    volatile Number sink = found; // keeps the work from being optimized away
+    (void)sink;
+    return time;
   }
+};
 
+// An LRU cache of the given capacity under a trace with about HitPercent % hits
+// (lru_performance.h). The trace is made from the seed, not from the dataset. The hit
+// rate the cache achieved is the note of the cell
+template<size_t HitPercent>
+struct LruAccess : TimedWorkload<LruAccess<HitPercent>>
+{
+  static std::string name() { return "lru_" + std::to_string(HitPercent); }
+  static std::vector<size_t> sweep() { return lruSweep(); }
+
+  template<typename Container, Number Size, typename Timing>
+  static TimeValue measure(const size_t capacity, const RunContext& context, Timing& timing)
   {
-    std::deque<POD_value>    deque;
-    deque_time = linearInsertPerformance<std::deque<POD_value>, POD_value>(values, deque);
+    typedef typename Container::template Of<POD<Size>> Storage;
+    const std::vector<Number> trace = lruTrace(capacity, kLruAccessesPerEntry * capacity, HitPercent, context.dataset.seed);
+    Storage cache(capacity);
+    lruWarmUp(cache);
+    prepareCache(context.cache_mode, trace, cache);
+    Number found = 0;
+    size_t hits = 0;
+    const TimeValue time = timing.each(trace, [&](const Number key) { found += lruAccess(cache, key, hits); });
+    volatile Number sink = found; // keeps the work from being optimized away
+    (void)sink;
+    noteCell(context, lruHitRate(hits, trace.size()));
+    return time;
   }
+};
 
+typedef TypeList<StdList, StdVector, StdDeque> Containers;
+// The unrolled list is only for trivially copyable elements and has no random access (sort)
+typedef TypeList<StdList, StdVector, StdDeque, BlockDeque1K, BlockDeque4K, Unrolled> PodContainers;
 
-  std::cout << "\t" << list_time << ",\t" << vector_time << ",\t" << deque_time;
-  std::cout << ",\tsizeof(POD): " << sizeof(POD_value) << " bytes" << std::endl << std::flush;
+typedef TypeList<LinearInsert, LinearErase, LinearSmartInsert> PodWorkloads;
+typedef SizeList<1, 2, 4, 8, 16, 32, 64> PodSizes; // 4 to 256 bytes
 
-}
+typedef TypeList<Sort> SortWorkloads;
+typedef TypeList<StdList, StdVector, StdDeque, StableSort, RunMergeSort, KeyIndexSort, RadixSort> SortContainers;
 
-   template<Number PodSizeIn4ByteIncrements>
-   void measure()
-   {
-     g2::StopWatch watch;
-     std::cout << "Measuring In Microseconds (us)" << std::endl;
-     std::cout << rows_explained << std::endl;
-
-     // small increments for measuring up to 4000
-     listVsVectorLinearPerformance<PodSizeIn4ByteIncrements>(100);
-     listVsVectorLinearPerformance<PodSizeIn4ByteIncrements>(200);
-     listVsVectorLinearPerformance<PodSizeIn4ByteIncrements>(400);
-     listVsVectorLinearPerformance<PodSizeIn4ByteIncrements>(800);
-     listVsVectorLinearPerformance<PodSizeIn4ByteIncrements>(1000);
-     listVsVectorLinearPerformance<PodSizeIn4ByteIncrements>(2000);
-     listVsVectorLinearPerformance<PodSizeIn4ByteIncrements>(3000);
-     listVsVectorLinearPerformance<PodSizeIn4ByteIncrements>(4000);
-     listVsVectorLinearPerformance<PodSizeIn4ByteIncrements>(5000);
-
-     // step it up till 100.000
-     for(auto cnt = 5000; cnt <= 40000; cnt+=5000)
-     {
-       listVsVectorLinearPerformance<PodSizeIn4ByteIncrements>(cnt);
-     }
-     auto total_time_ms = watch.elapsedMs().count();
-     std::cout << "[" << rows_explained << "]" << std::endl;
+typedef TypeList<LinearMoveInsert<MoveOnlyRecord>,
+                 LinearMoveInsert<HeavyCopyRecord>,
+                 LinearMoveInsert<NoexceptMoveRecord>,
+                 LinearMoveInsert<ThrowingMoveRecord>> ElementWorkloads;
+typedef SizeList<1, 16, 64> ElementPodSizes; // 4, 64 and 256 bytes payload
 
-     typedef POD<PodSizeIn4ByteIncrements> POD_value;
-     std::cout << "Test finished for " << sizeof(POD_value) << " bytes POD" << std::endl;
-     std::cout << "The POD sized test took " << total_time_ms << " milliseconds (or " << total_time_ms/1000 << " seconds)\n\n" << std::endl;
-   }
+typedef TypeList<StdList, StdVector, StdDeque, Unrolled, CountedTree> RankContainers;
+typedef TypeList<RankInsert, RankErase> RankWorkloads;
+typedef SizeList<1, 16, 64> RankPodSizes;
+
+typedef TypeList<FlatSortedMap, StdMap, StdUnorderedMap, OpenAddressing> Maps;
+typedef TypeList<KvInsert, KvLookup, KvErase, KvIterate, KvMixed> KeyValueWorkloads;
+typedef SizeList<1, 4, 16> KeyValuePodSizes; // 4, 16 and 64 bytes values
+
+typedef TypeList<StdList, StdVector, SearchTree> LookupContainers;
+typedef TypeList<BatchedLookup<1>, BatchedLookup<8>, BatchedLookup<32>> LookupWorkloads;
+typedef SizeList<1, 16> LookupPodSizes; // 4 and 64 bytes
 
+typedef TypeList<StdList, StdVector, Eytzinger, Veb> LayoutContainers;
+typedef TypeList<LayoutLookup> LayoutWorkloads;
 
+typedef TypeList<ListLru, ArrayLru, Clock> LruContainers;
+typedef TypeList<LruAccess<50>, LruAccess<75>, LruAccess<90>, LruAccess<99>> LruWorkloads;
+typedef SizeList<1, 16> LruPodSizes; // 4 and 64 bytes
 
+
+
+   // Usage: see benchmark_runner.h or run with --help. Example:
+   //   list_vs_vector_POD --scenarios=linear_insert --containers=list,vector --sizes=100:20000 --budget-ms=2000 "POD<16>"
+   // Sorting of presorted input, one table per input:
+   //   list_vs_vector_POD --scenarios=sort --input=uniform,ascending,descending,nearly_sorted,runs "POD<4>"
+   // On a toolchain upgrade, save a baseline with the old one and compare with the new one:
+   //   list_vs_vector_POD --reps=5 --sizes=100:5000 --save-baseline=baseline.txt
+   //   list_vs_vector_POD --reps=5 --sizes=100:5000 --baseline=baseline.txt   (exits with 2 on a regression)
    int main(int argc, char** argv)
    {
+     RunnerOptions options;
+     if (!parseRunnerOptions(argc, argv, options)) {
+       return 1;
+     }
+     if (options.help) {
+       return 0;
+     }
+     BaselineResults baseline; // read before the run, a bad file should not waste a run
+     if (!options.baseline.empty() && !readBaseline(options.baseline, baseline)) {
+       return 1;
+     }
+
+     BenchmarkMatrix matrix;
+     registerMatrix(matrix, PodWorkloads(), PodSizes(), PodContainers());
+     registerMatrix(matrix, SortWorkloads(), PodSizes(), SortContainers());
+     registerMatrix(matrix, ElementWorkloads(), ElementPodSizes(), Containers());
+     registerMatrix(matrix, RankWorkloads(), RankPodSizes(), RankContainers());
+     registerMatrix(matrix, KeyValueWorkloads(), KeyValuePodSizes(), Maps());
+     registerMatrix(matrix, LookupWorkloads(), LookupPodSizes(), LookupContainers());
+     registerMatrix(matrix, LayoutWorkloads(), LookupPodSizes(), LayoutContainers());
+     registerMatrix(matrix, LruWorkloads(), LruPodSizes(), LruContainers());
+     matrix = selectCells(matrix, options);
+     if (options.list_only) {
+       listMatrix(matrix);
+       return 0;
+     }
+
      g2::StopWatch watch;
-     measure<1>(); // measure 4 bytes
-     measure<2>(); // measure 8 bytes
-     measure<4>(); // measure 16 bytes
-     measure<8>(); // 32 bytes
-     measure<16>(); // 64 bytes
-     measure<32>(); // 128 bytes*/
-     measure<64>(); // 256 bytes
+     const MemoryProfile memory = probeMemory(); // reported with the results, and saved with a baseline
+     BaselineResults results = runMatrix(matrix, options, memory);
+
      auto total_time_s = watch.elapsedMs().count()/1000;
      std::cout << "\n\n**********************************************\n" << std::endl;
      std::cout << "Exiting test: the whole measuring took " << total_time_s << " seconds";
      std::cout << " (or " << total_time_s/(60) << " minutes)" << std::endl;
 
-     return 0;
+     // exits with 2 when a cell regressed against the --baseline
+     return finishBaseline(results, baseline, options, memory);
    }
-
-
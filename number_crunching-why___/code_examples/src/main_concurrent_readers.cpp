@@ -0,0 +1,75 @@
+//
+// Concurrent readers during insertion: N reader threads look up random keys in a sorted
+// set while one writer thread inserts and erases (concurrent_readers.h). A mutex guarded
+// std::list, a reader-writer locked std::vector and a copy-on-write snapshot vector
+// (RCU style). Each row shows the lookups per second of all readers together, the
+// latency of a single lookup and the updates per second of the writer
+//
+
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <algorithm>
+
+#include "g2_chrono.h"
+#include "pod_performance.h"
+#include "latency_histogram.h"
+#include "concurrent_readers.h"
+#include "memory_probe.h"
+
+
+const long long kRunMs = 200; // per row
+const std::string rows_explained = "elements   readers   container          reads/s   read_p50[ns]   read_p99[ns]   read_max[ns]     writes/s";
+
+
+void printRow(const size_t nbr_of_elements, const size_t nbr_of_readers, const std::string& container,
+              const ConcurrentResult& result)
+{
+  const double seconds = double(std::max(result.elapsed_us, TimeValue(1))) / 1000000;
+  const LatencySummary reads = summarize(result.reads);
+  std::cout << std::setw(8) << nbr_of_elements << std::setw(10) << nbr_of_readers << "   ";
+  std::cout << std::left << std::setw(15) << container << std::right;
+  std::cout << std::setw(11) << (long long)(double(reads.count) / seconds);
+  std::cout << std::setw(15) << g2::cyclesToNs(reads.p50).count();
+  std::cout << std::setw(15) << g2::cyclesToNs(reads.p99).count();
+  std::cout << std::setw(15) << g2::cyclesToNs(reads.max).count();
+  std::cout << std::setw(13) << (long long)(double(result.writes) / seconds) << std::endl;
+}
+
+
+void concurrentReaders(const size_t nbr_of_elements, const size_t nbr_of_readers)
+{
+  const uint64_t seed = 2012;
+  const std::vector<Number> sorted = sortedRandomKeys(nbr_of_elements, seed);
+  printRow(nbr_of_elements, nbr_of_readers, "locked_list",
+           concurrentReadersPerformance<LockedList>(sorted, nbr_of_readers, kRunMs, seed));
+  printRow(nbr_of_elements, nbr_of_readers, "rwlock_vector",
+           concurrentReadersPerformance<RwLockedVector>(sorted, nbr_of_readers, kRunMs, seed));
+  printRow(nbr_of_elements, nbr_of_readers, "snapshot_vector",
+           concurrentReadersPerformance<SnapshotVector>(sorted, nbr_of_readers, kRunMs, seed));
+}
+
+
+int main(int argc, char** argv)
+{
+  g2::cyclesPerNs(); // calibrate the TSC before anything is measured
+  g2::StopWatch watch;
+  std::cout << "Concurrent readers and one writer, " << kRunMs << " ms per row, ";
+  std::cout << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+  printMemoryProfile(probeMemory(), std::cout);
+  std::cout << rows_explained << std::endl;
+  for (size_t nbr_of_elements : {1000, 10000, 100000})
+  {
+    for (size_t nbr_of_readers : {1, 2, 4}) {
+      concurrentReaders(nbr_of_elements, nbr_of_readers);
+    }
+    std::cout << std::endl;
+  }
+  auto total_time_s = watch.elapsedMs().count()/1000;
+  std::cout << "\n\n**********************************************\n" << std::endl;
+  std::cout << "Exiting test: the whole measuring took " << total_time_s << " seconds";
+  std::cout << " (or " << total_time_s/(60) << " minutes)" << std::endl;
+  return 0;
+}
@@ -0,0 +1,102 @@
+//
+// Growth policy study: linear insert of random POD elements into vectors that grow
+// by 1.5x, 2x or are reserved to the exact size up front. Each row shows the insert
+// time together with the number of reallocations, the copied bytes and the slowest
+// single regrowth, i.e. the latency spike that a regrowth causes
+//
+
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <algorithm>
+
+#include "g2_chrono.h"
+#include "pod_performance.h"
+#include "growth_vector.h"
+#include "memory_probe.h"
+
+
+const std::string rows_explained = "elements   policy             insert_time[us]   reallocations   copied_bytes   longest_regrowth[us]";
+
+
+void printRow(const size_t nbr_of_randoms, const std::string& policy, const TimeValue time, const GrowthStats* stats)
+{
+  std::cout << std::setw(8) << nbr_of_randoms << "   " << std::left << std::setw(19) << policy << std::right;
+  std::cout << std::setw(15) << time;
+  if (nullptr == stats) { // std::vector does not tell
+    std::cout << std::setw(16) << "-" << std::setw(15) << "-" << std::setw(23) << "-" << std::endl;
+    return;
+  }
+  std::cout << std::setw(16) << stats->reallocations << std::setw(15) << stats->bytes_copied;
+  std::cout << std::setw(23) << stats->longest_regrowth_us << std::endl;
+}
+
+
+template<typename Growth, typename Relocation, Number SizeOfPod>
+void growthPerformance(const std::vector<POD<SizeOfPod>>& values, const std::string& policy)
+{
+  typedef POD<SizeOfPod> POD_value;
+  typedef GrowthVector<POD_value, Growth, Relocation> Container;
+  Container vector;
+  g2::StopWatch watch;
+  if (Growth::kReserveUpFront) {
+    vector.reserve(values.size());
+  }
+  linearInsertion(values, vector);
+  TimeValue time = watch.elapsedUs().count();
+  printRow(values.size(), policy, time, &vector.stats());
+}
+
+
+template<Number SizeOfPod>
+void growthPolicyPerformance(const size_t nbr_of_randoms)
+{
+  typedef POD<SizeOfPod> POD_value;
+  const uint64_t seed = 2012;
+  std::vector<POD_value> values = randomPODs<SizeOfPod>(nbr_of_randoms, seed);
+  {
+    std::vector<POD_value> vector;
+    TimeValue time = linearInsertPerformance(values, vector);
+    printRow(nbr_of_randoms, "std::vector", time, nullptr);
+  }
+  growthPerformance<GrowByFactor<3,2>, MoveRelocation>(values, "1.5x move");
+  growthPerformance<GrowByFactor<3,2>, ReallocRelocation>(values, "1.5x realloc");
+  growthPerformance<GrowByFactor<2,1>, MoveRelocation>(values, "2x move");
+  growthPerformance<GrowByFactor<2,1>, ReallocRelocation>(values, "2x realloc");
+  growthPerformance<ExactReserve, MoveRelocation>(values, "exact-reserve");
+  std::cout << std::endl;
+}
+
+
+template<Number PodSizeIn4ByteIncrements>
+void measure()
+{
+  g2::StopWatch watch;
+  typedef POD<PodSizeIn4ByteIncrements> POD_value;
+  std::cout << "Measuring growth policies for " << sizeof(POD_value) << " bytes POD" << std::endl;
+  std::cout << rows_explained << std::endl;
+  growthPolicyPerformance<PodSizeIn4ByteIncrements>(1000);
+  growthPolicyPerformance<PodSizeIn4ByteIncrements>(5000);
+  growthPolicyPerformance<PodSizeIn4ByteIncrements>(10000);
+  growthPolicyPerformance<PodSizeIn4ByteIncrements>(20000);
+  auto total_time_ms = watch.elapsedMs().count();
+  std::cout << "The POD sized test took " << total_time_ms << " milliseconds (or " << total_time_ms/1000 << " seconds)\n\n" << std::endl;
+}
+
+
+int main(int argc, char** argv)
+{
+  g2::StopWatch watch;
+  printMemoryProfile(probeMemory(), std::cout);
+  std::cout << std::endl;
+  measure<1>(); // 4 bytes
+  measure<4>(); // 16 bytes
+  measure<16>(); // 64 bytes
+  measure<64>(); // 256 bytes
+  auto total_time_s = watch.elapsedMs().count()/1000;
+  std::cout << "\n\n**********************************************\n" << std::endl;
+  std::cout << "Exiting test: the whole measuring took " << total_time_s << " seconds";
+  std::cout << " (or " << total_time_s/(60) << " minutes)" << std::endl;
+  return 0;
+}
@@ -0,0 +1,181 @@
+#ifndef MEMORY_PROBE_H_
+#define MEMORY_PROBE_H_
+
+// Memory calibration of the host, reported together with the measurements so that
+// list/vector timings from different machines can be put in relation to each other.
+//
+// Latency: a random pointer chase through a buffer of cache lines. Every load depends
+// on the previous one and the order is a random single cycle (Sattolo's algorithm),
+// so the prefetchers cannot help. Run at half the size of each cache level, where
+// the buffer fits, and far above the last level where every load goes to RAM
+// (including the TLB misses that a list traversal would get too).
+//
+// Bandwidth: a sequential read (sum) and write (fill) over a buffer larger than the
+// last level cache, in GB/s.
+// Include "g2_chrono.h" before this file.
+
+#include <vector>
+#include <string>
+#include <random>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#if defined(__unix__)
+#include <unistd.h>
+#endif
+
+
+struct MemoryLevel
+{
+  std::string name;
+  size_t bytes;       // size of the chased buffer
+  double latency_ns;  // per load
+};
+
+struct MemoryProfile
+{
+  std::vector<MemoryLevel> levels;
+  size_t stream_bytes;
+  double read_gb_per_s;
+  double write_gb_per_s;
+
+  MemoryProfile() : stream_bytes(0), read_gb_per_s(0), write_gb_per_s(0) {}
+};
+
+
+// Data cache size of 'level' (1-3) if the system tells, else 0
+size_t dataCacheSize(const int level)
+{
+  long size = 0;
+#if defined(_SC_LEVEL1_DCACHE_SIZE) && defined(_SC_LEVEL3_CACHE_SIZE)
+  const int names[] = {_SC_LEVEL1_DCACHE_SIZE, _SC_LEVEL2_CACHE_SIZE, _SC_LEVEL3_CACHE_SIZE};
+  if (level >= 1 && level <= 3) {
+    size = sysconf(names[level - 1]);
+  }
+#else
+  (void)level;
+#endif
+  return (size > 0) ? size_t(size) : 0;
+}
+
+// Nanoseconds per load for a random pointer chase through 'bytes' of cache lines
+double chaseLatencyNs(const size_t bytes, const size_t steps)
+{
+  const size_t kLine = 64;
+  const size_t lines = std::max(size_t(2), bytes / kLine);
+  std::vector<char> buffer((lines + 1) * kLine);
+  char* base = buffer.data() + (kLine - reinterpret_cast<uintptr_t>(buffer.data()) % kLine) % kLine;
+
+  // Sattolo: a random permutation that is one single cycle through all lines
+  std::vector<size_t> order(lines);
+  for (size_t idx = 0; idx != lines; ++idx) {
+    order[idx] = idx;
+  }
+  std::mt19937 engine(2012);
+  for (size_t idx = lines - 1; idx > 0; --idx)
+  {
+    std::uniform_int_distribution<size_t> pick(0, idx - 1);
+    std::swap(order[idx], order[pick(engine)]);
+  }
+  for (size_t idx = 0; idx != lines; ++idx)
+  {
+    void* next = base + order[idx] * kLine;
+    std::memcpy(base + idx * kLine, &next, sizeof(next));
+  }
+
+  void* position = base;
+  for (size_t step = 0; step != lines; ++step) { // once around to warm up
+    position = *static_cast<void**>(position);
+  }
+  g2::CycleStopWatch watch;
+  for (size_t step = 0; step != steps; ++step) {
+    position = *static_cast<void**>(position);
+  }
+  // stored before the clock is read, else the chase may be moved past it or optimized away
+  void* volatile sink = position;
+  (void)sink;
+  return double(watch.elapsedNs().count()) / double(steps);
+}
+
+// GB/s for reading and writing a buffer of 'bytes', best of a few passes
+void streamBandwidth(const size_t bytes, double& read_gb_per_s, double& write_gb_per_s)
+{
+  std::vector<uint64_t> buffer(bytes / sizeof(uint64_t), 1);
+  double best_read_ns = 0;
+  double best_write_ns = 0;
+  volatile uint64_t sink = 0;
+  for (int pass = 0; pass != 3; ++pass)
+  {
+    g2::CycleStopWatch read_watch;
+    uint64_t sum = 0;
+    for (auto word : buffer) {
+      sum += word;
+    }
+    sink = sum; // before the clock is read, see chaseLatencyNs
+    const double read_ns = double(read_watch.elapsedNs().count());
+
+    g2::CycleStopWatch write_watch;
+    std::fill(buffer.begin(), buffer.end(), uint64_t(pass));
+    const double write_ns = double(write_watch.elapsedNs().count());
+
+    best_read_ns = (0 == pass) ? read_ns : std::min(best_read_ns, read_ns);
+    best_write_ns = (0 == pass) ? write_ns : std::min(best_write_ns, write_ns);
+  }
+  (void)sink;
+  const double stream_bytes = double(buffer.size() * sizeof(uint64_t));
+  read_gb_per_s = (best_read_ns > 0) ? stream_bytes / best_read_ns : 0;
+  write_gb_per_s = (best_write_ns > 0) ? stream_bytes / best_write_ns : 0;
+}
+
+
+// Run the probes, takes around half a second
+MemoryProfile probeMemory()
+{
+  const size_t kFallbacks[] = {32 << 10, 256 << 10, 8 << 20};
+  const char* names[] = {"L1", "L2", "L3"};
+  MemoryProfile profile;
+  size_t largest = 0;
+  for (int level = 1; level <= 3; ++level)
+  {
+    const size_t cache = dataCacheSize(level);
+    const size_t size = (cache > 0) ? cache : kFallbacks[level - 1];
+    if (size <= largest) {
+      continue; // e.g. no L3, reported as the L2 size
+    }
+    largest = size;
+    MemoryLevel probe = {names[level - 1], size / 2, 0};
+    probe.latency_ns = chaseLatencyNs(probe.bytes, 4000000);
+    profile.levels.push_back(probe);
+  }
+  // far above the last level, but not more than 512MB on hosts with huge caches
+  const size_t ram_bytes = std::min(size_t(512) << 20, std::max(size_t(64) << 20, 8 * largest));
+  MemoryLevel ram = {"RAM", ram_bytes, chaseLatencyNs(ram_bytes, 2000000)};
+  profile.levels.push_back(ram);
+
+  profile.stream_bytes = std::min(size_t(512) << 20, std::max(size_t(64) << 20, 4 * largest));
+  streamBandwidth(profile.stream_bytes, profile.read_gb_per_s, profile.write_gb_per_s);
+  return profile;
+}
+
+// Every line starts with 'prefix', e.g. "# " for the comment lines of a baseline file
+void printMemoryProfile(const MemoryProfile& profile, std::ostream& out, const std::string& prefix = "")
+{
+  std::ostringstream latency;
+  latency << std::fixed << std::setprecision(1);
+  for (auto& level : profile.levels)
+  {
+    latency << (latency.tellp() > 0 ? ", " : "") << level.name << " (" << (level.bytes >> 10) << "KB) ";
+    latency << level.latency_ns << " ns";
+  }
+  out << prefix << "Memory latency, random pointer chase per load (buffer size): " << latency.str() << std::endl;
+  out << prefix << "Memory bandwidth, streaming " << (profile.stream_bytes >> 20) << "MB: " << std::fixed;
+  out << std::setprecision(1) << "read " << profile.read_gb_per_s << " GB/s, write " << profile.write_gb_per_s;
+  out << " GB/s" << std::endl;
+  out.unsetf(std::ios::floatfield);
+  out << std::setprecision(6);
+}
+
+#endif // MEMORY_PROBE_H_
@@ -0,0 +1,148 @@
+#ifndef OPEN_ADDRESSING_MAP_H_
+#define OPEN_ADDRESSING_MAP_H_
+
+// Open addressing hash map with linear probing. Keys and values live in one flat slot
+// array, a collision just means looking in the next slot, i.e. the next bytes in the
+// same or the next cache line. Compare std::unordered_map that allocates a node per
+// element and follows a pointer for every lookup.
+//
+// The capacity is a power of two and the table grows at 50% load, the hash is
+// Fibonacci hashing (multiply by 2^64/phi and keep the top bits). Erase uses backward
+// shift deletion, so there are no tombstones and lookups do not slow down over time.
+// The key must be an integral type.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <utility>
+
+
+template<typename Key, typename Value>
+class OpenAddressingMap
+{
+  struct Slot
+  {
+    Key key;
+    bool used;
+    Value value;
+  };
+
+  std::vector<Slot> slots_;
+  size_t size_;
+  unsigned shift_;     // 64 - log2(capacity)
+
+  size_t mask() const { return slots_.size() - 1; }
+
+  size_t home(const Key& key) const
+  {
+    return size_t((uint64_t(key) * 11400714819323198485ull) >> shift_);
+  }
+
+  size_t probe(const Key& key) const
+  {
+    size_t index = home(key);
+    while (slots_[index].used && slots_[index].key != key) {
+      index = (index + 1) & mask();
+    }
+    return index;
+  }
+
+  void rehash(size_t capacity)
+  {
+    std::vector<Slot> old(capacity);
+    old.swap(slots_);
+    shift_ = 64;
+    for (size_t bits = capacity; bits > 1; bits >>= 1) {
+      --shift_;
+    }
+    for (auto& slot : old)
+    {
+      if (slot.used) {
+        slots_[probe(slot.key)] = slot;
+      }
+    }
+  }
+
+public:
+  typedef Key key_type;
+  typedef Value mapped_type;
+
+  OpenAddressingMap() : size_(0), shift_(0) { rehash(16); }
+
+  OpenAddressingMap(const OpenAddressingMap&) = delete;
+  OpenAddressingMap& operator=(const OpenAddressingMap&) = delete;
+
+  // Returns false if the key was already there, the old value is then kept
+  bool insert(const Key& key, const Value& value)
+  {
+    if (2 * (size_ + 1) > slots_.size()) {
+      rehash(2 * slots_.size());
+    }
+    Slot& slot = slots_[probe(key)];
+    if (slot.used) {
+      return false;
+    }
+    slot.key = key;
+    slot.used = true;
+    slot.value = value;
+    ++size_;
+    return true;
+  }
+
+  // nullptr if the key is not there
+  const Value* find(const Key& key) const
+  {
+    const Slot& slot = slots_[probe(key)];
+    return slot.used ? &slot.value : nullptr;
+  }
+
+  bool erase(const Key& key)
+  {
+    size_t hole = probe(key);
+    if (!slots_[hole].used) {
+      return false;
+    }
+    // shift back every following element of the probe run that may move to the hole
+    size_t next = (hole + 1) & mask();
+    while (slots_[next].used)
+    {
+      const size_t wanted = home(slots_[next].key);
+      const bool movable = (hole <= next) ? (wanted <= hole || wanted > next)
+                                          : (wanted <= hole && wanted > next);
+      if (movable)
+      {
+        slots_[hole] = slots_[next];
+        hole = next;
+      }
+      next = (next + 1) & mask();
+    }
+    slots_[hole].used = false;
+    --size_;
+    return true;
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return 0 == size_; }
+
+  // Visit every (key, value) in slot order, i.e. in no particular order
+  template<typename Visit>
+  void forEach(Visit visit) const
+  {
+    for (auto& slot : slots_)
+    {
+      if (slot.used) {
+        visit(slot.key, slot.value);
+      }
+    }
+  }
+
+  // The slot array, empty slots included: a lookup probes those too. For the cache
+  // modes of cache_mode.h, visit(address, bytes)
+  template<typename Visit>
+  void forEachRange(Visit visit) const
+  {
+    visit(slots_.data(), slots_.size() * sizeof(Slot));
+  }
+};
+
+#endif // OPEN_ADDRESSING_MAP_H_
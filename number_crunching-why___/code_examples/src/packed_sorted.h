@@ -0,0 +1,261 @@
+#ifndef PACKED_SORTED_H_
+#define PACKED_SORTED_H_
+
+// Sorted unsigned 32-bit numbers stored delta encoded and bit packed in blocks of
+// up to 128 numbers. The sorted vector keeps 4 bytes per number, but the distance
+// between sorted neighbours is small: n random numbers below n are mostly 0-3 apart,
+// i.e. 2-3 bits. Less bytes per number is less memory to stream through on a search.
+//
+// A block is its first number (the base) and the deltas to the previous number packed
+// with the bit width of the largest delta. The deltas are laid out vertically in 4
+// lanes (number i is in lane i % 4) so that SSE2 can unpack 4 at a time with one
+// shift count for all lanes and turn them back into numbers with an in-register
+// prefix sum. Without SSE2 the same layout is decoded one number at a time.
+//
+// A search scans the bases of the blocks, which are kept in their own array, and
+// decodes the one block the number belongs to. Insert and erase decode that block,
+// change it and encode it again. Only that block is re-encoded: a full block is split
+// in two halves and an emptied block is removed.
+//
+// Only what the linear insert/erase tests need is implemented: insert(number),
+// eraseAt(position), size, empty, bytes() for the memory actually used and
+// forEachRange.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PACKED_SORTED_SSE2
+#endif
+
+
+class PackedSortedNumbers
+{
+public:
+  static const size_t kBlockCapacity = 128; // 32 rows of 4 lanes
+
+private:
+  struct Block
+  {
+    uint32_t count;
+    uint32_t bits;                // width of every delta
+    std::vector<uint32_t> words;  // 4 * bits words, 'bits' rows of 4 lanes
+  };
+
+  std::vector<uint32_t> bases_;   // first number of every block, scanned on search
+  std::vector<Block> blocks_;
+  size_t size_;
+
+  static uint32_t maskOf(const uint32_t bits)
+  {
+    return (32 == bits) ? ~0u : (1u << bits) - 1;
+  }
+
+  // 'numbers' get the 'block.count' numbers of the block, and up to 3 numbers more
+  // that repeat the last one. Room for kBlockCapacity + 1 numbers is expected
+  static void decode(const uint32_t base, const Block& block, uint32_t* numbers)
+  {
+    const size_t rows = (block.count + 3) / 4;
+    const uint32_t bits = block.bits;
+    if (0 == bits)
+    {
+      for (size_t idx = 0; idx != rows * 4; ++idx) {
+        numbers[idx] = base;
+      }
+      return;
+    }
+    const uint32_t* words = block.words.data();
+#if defined(PACKED_SORTED_SSE2)
+    const __m128i mask = _mm_set1_epi32(int(maskOf(bits)));
+    __m128i previous = _mm_set1_epi32(int(base));
+    for (size_t row = 0; row != rows; ++row)
+    {
+      const size_t bit = row * bits;
+      const size_t word = bit / 32;
+      const int shift = int(bit % 32);
+      __m128i deltas = _mm_srl_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(words + 4 * word)),
+                                     _mm_cvtsi32_si128(shift));
+      if (shift + bits > 32)
+      {
+        const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + 4 * (word + 1)));
+        deltas = _mm_or_si128(deltas, _mm_sll_epi32(high, _mm_cvtsi32_si128(32 - shift)));
+      }
+      deltas = _mm_and_si128(deltas, mask);
+      // prefix sum of the 4 lanes, plus the last number of the row before
+      deltas = _mm_add_epi32(deltas, _mm_slli_si128(deltas, 4));
+      deltas = _mm_add_epi32(deltas, _mm_slli_si128(deltas, 8));
+      previous = _mm_add_epi32(deltas, _mm_shuffle_epi32(previous, 0xFF));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(numbers + 4 * row), previous);
+    }
+#else
+    const uint32_t mask = maskOf(bits);
+    uint32_t previous = base;
+    for (size_t idx = 0; idx != rows * 4; ++idx)
+    {
+      const size_t bit = (idx / 4) * bits;
+      const size_t word = 4 * (bit / 32) + idx % 4;
+      const uint32_t shift = bit % 32;
+      uint32_t delta = words[word] >> shift;
+      if (shift + bits > 32) {
+        delta |= words[word + 4] << (32 - shift);
+      }
+      previous += delta & mask;
+      numbers[idx] = previous;
+    }
+#endif
+  }
+
+  // Encode the 'count' sorted 'numbers' into 'block', numbers[0] is the base
+  static void encode(const uint32_t* numbers, const size_t count, Block& block)
+  {
+    uint32_t largest = 0;
+    for (size_t idx = 1; idx < count; ++idx)
+    {
+      const uint32_t delta = numbers[idx] - numbers[idx - 1];
+      largest = (delta > largest) ? delta : largest;
+    }
+    uint32_t bits = 0;
+    for (; bits < 32 && (largest >> bits) != 0; ++bits) {}
+
+    block.count = uint32_t(count);
+    block.bits = bits;
+    block.words.assign(4 * bits, 0);
+    if (0 == bits) {
+      return;
+    }
+    for (size_t idx = 1; idx < count; ++idx) // the delta of the base is 0
+    {
+      const uint32_t delta = numbers[idx] - numbers[idx - 1];
+      const size_t bit = (idx / 4) * bits;
+      const size_t word = 4 * (bit / 32) + idx % 4;
+      const uint32_t shift = bit % 32;
+      block.words[word] |= delta << shift;
+      if (shift + bits > 32) {
+        block.words[word + 4] |= delta >> (32 - shift);
+      }
+    }
+  }
+
+  // Encode 'count' numbers into block 'index', split it in two when it overflowed
+  void store(const size_t index, const uint32_t* numbers, const size_t count)
+  {
+    if (count <= kBlockCapacity)
+    {
+      encode(numbers, count, blocks_[index]);
+      bases_[index] = numbers[0];
+      return;
+    }
+    const size_t half = count / 2;
+    encode(numbers, half, blocks_[index]);
+    bases_[index] = numbers[0];
+    Block upper;
+    encode(numbers + half, count - half, upper);
+    blocks_.insert(blocks_.begin() + index + 1, std::move(upper));
+    bases_.insert(bases_.begin() + index + 1, numbers[half]);
+  }
+
+public:
+  typedef uint32_t value_type;
+
+  PackedSortedNumbers() : size_(0) {}
+
+  PackedSortedNumbers(const PackedSortedNumbers&) = delete;
+  PackedSortedNumbers& operator=(const PackedSortedNumbers&) = delete;
+
+  size_t size() const { return size_; }
+  bool empty() const  { return 0 == size_; }
+
+  // Insert in sorted order, before the first number that is >= 'number'
+  void insert(const uint32_t number)
+  {
+    uint32_t numbers[kBlockCapacity + 4];
+    if (blocks_.empty())
+    {
+      blocks_.push_back(Block());
+      bases_.push_back(number);
+      numbers[0] = number;
+      store(0, numbers, 1);
+      ++size_;
+      return;
+    }
+    // the last block that starts at or below 'number'
+    size_t index = 0;
+    while (index + 1 < bases_.size() && bases_[index + 1] < number) {
+      ++index;
+    }
+    const Block& block = blocks_[index];
+    decode(bases_[index], block, numbers);
+    size_t position = 0;
+    while (position != block.count && numbers[position] < number) {
+      ++position;
+    }
+    for (size_t idx = block.count; idx != position; --idx) {
+      numbers[idx] = numbers[idx - 1];
+    }
+    numbers[position] = number;
+    store(index, numbers, block.count + 1);
+    ++size_;
+  }
+
+  // Erase the number at 'position' in the sorted order. position < size()
+  void eraseAt(size_t position)
+  {
+    size_t index = 0;
+    while (position >= blocks_[index].count)
+    {
+      position -= blocks_[index].count;
+      ++index;
+    }
+    --size_;
+    const Block& block = blocks_[index];
+    if (1 == block.count)
+    {
+      blocks_.erase(blocks_.begin() + index);
+      bases_.erase(bases_.begin() + index);
+      return;
+    }
+    uint32_t numbers[kBlockCapacity + 4];
+    decode(bases_[index], block, numbers);
+    for (size_t idx = position + 1; idx != block.count; ++idx) {
+      numbers[idx - 1] = numbers[idx];
+    }
+    store(index, numbers, block.count - 1);
+  }
+
+  // All the numbers in sorted order, for verification
+  std::vector<uint32_t> decodeAll() const
+  {
+    std::vector<uint32_t> all;
+    uint32_t numbers[kBlockCapacity + 4];
+    for (size_t index = 0; index != blocks_.size(); ++index)
+    {
+      decode(bases_[index], blocks_[index], numbers);
+      all.insert(all.end(), numbers, numbers + blocks_[index].count);
+    }
+    return all;
+  }
+
+  // Every range of memory held, for the cache modes of cache_mode.h, visit(address, bytes)
+  template<typename Visit>
+  void forEachRange(Visit visit) const
+  {
+    visit(bases_.data(), bases_.size() * sizeof(uint32_t));
+    visit(blocks_.data(), blocks_.size() * sizeof(Block));
+    for (auto& block : blocks_) {
+      visit(block.words.data(), block.words.size() * sizeof(uint32_t));
+    }
+  }
+
+  // Bytes of memory held, including the unused capacity of the vectors
+  size_t bytes() const
+  {
+    size_t total = sizeof(*this) + bases_.capacity() * sizeof(uint32_t) + blocks_.capacity() * sizeof(Block);
+    for (auto& block : blocks_) {
+      total += block.words.capacity() * sizeof(uint32_t);
+    }
+    return total;
+  }
+};
+
+#endif // PACKED_SORTED_H_
@@ -0,0 +1,199 @@
+#ifndef POD_PERFORMANCE_H_
+#define POD_PERFORMANCE_H_
+
+// POD test helpers shared by the POD sized comparisons: the variadic sized POD,
+// the random number generator and the templated linear insert with timing.
+// Include "g2_chrono.h" before this file.
+
+#include <list>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <functional>
+#include <algorithm>
+
+
+typedef unsigned int  Number;
+typedef long long int            TimeValue;
+
+
+// Silly POD to test with variadic POD size
+template<Number Size>
+struct POD
+{
+   Number a[Size];
+
+  bool operator>=(const POD& b) const
+  {
+    return (this->a[0] >= b.a[0]);
+  }
+};
+
+/* ???? below works on nix but not on windows 2011)
+// Random integer function from http://www2.research.att.com/~bs/C++0xFAQ.html#std-random
+int random_int(int low, int high)
+{
+  using namespace std;
+  static default_random_engine engine {};
+  typedef uniform_int_distribution<int> Distribution;
+  static Distribution distribution {};
+  return distribution(engine, Distribution::param_type{low, high});
+}
+*/
+
+/*
+// Generate a random number using the 'mersenne twister distribution'
+// http://en.wikipedia.org/wiki/Mersenne_twister
+// Random numbers are chosen within the range limits of 'low' and 'high'
+int random_int(int low, int high)
+{
+    std::uniform_int_distribution<int> distribution(low, high);
+    static std::mt19937 engine((unsigned int)time(0)); // Mersenne twister MT19937
+    auto generator = std::bind(distribution, engine);
+    return generator();
+};
+*/
+// Random integer function from http://www2.research.att.com/~bs/C++0xFAQ.html#std-random
+int random_int(int low, int high)
+{
+  using namespace std;
+  static default_random_engine engine;
+  typedef uniform_int_distribution<int> Distribution;
+  static Distribution distribution;
+  return distribution(engine, Distribution::param_type(low, high));
+}
+
+
+// Generate n random PODs. Only the key, a[0], is set. It is chosen within [0, n-1].
+// Seeded, not random_int: the same (n, seed) gives the same PODs however many times it
+// is called, so every container in a row gets the very same input
+template<Number Size>
+std::vector<POD<Size>> randomPODs(const size_t nbr_of_randoms, const uint64_t seed)
+{
+  std::vector<POD<Size>> values(nbr_of_randoms);
+  std::mt19937 engine(static_cast<std::mt19937::result_type>(seed));
+  std::uniform_int_distribution<Number> distribution(0, Number(nbr_of_randoms - 1));
+  std::for_each(values.begin(), values.end(), [&](POD<Size>& n) { n.a[0] = distribution(engine);});
+  return values;
+}
+
+
+// Insert one element in SORTED order, the position is found with a LINEAR search
+template<typename ValueType, typename Container>
+void linearInsertOne(const ValueType& n, Container& container)
+{
+    auto itr = container.begin();
+    for (; itr!= container.end(); ++itr)
+    {
+        if ((*itr) >= n) {
+            break;
+        }
+    }
+    container.insert(itr, n);
+}
+
+// Use a template approach to use functor, function pointer or lambda to insert an
+// element in the input container and return the "time result".
+// Search is LINEAR. Elements are insert in SORTED order
+// 'Values' is any range of values, e.g. a std::vector or a MappedDataset (dataset.h)
+template<typename Values, typename Container>
+void linearInsertion(const Values& numbers, Container& container)
+{
+    for (auto& n : numbers) {
+        linearInsertOne(n, container);
+    }
+}
+
+// Measure time in microseconds (us) for linear insert in a std container
+template<typename Values, typename Container>
+TimeValue linearInsertPerformance(const Values& randoms, Container& container)
+{
+    g2::StopWatch watch;
+    linearInsertion(randoms, container);
+    auto time = watch.elapsedUs().count();
+    return time;
+}
+
+
+// Same linear insert but each POD is first turned into an 'Element' that is moved
+// into the container. Works for move-only element types, see element_types.h
+template<typename Element, typename Container, Number Size>
+void linearMoveInsertOne(const POD<Size>& n, Container& container)
+{
+    Element element(n);
+    auto itr = container.begin();
+    for (; itr!= container.end(); ++itr)
+    {
+        if ((*itr) >= element) {
+            break;
+        }
+    }
+    container.insert(itr, std::move(element));
+}
+
+
+// A little bit smarter --- remembers the last insertion point's position and can
+// start from that if wanted-position is >= last-position: this is calculated from the values
+// and not from the absolute positions. From ideone_XprUU.cpp, but for any container
+template<typename ValueType, typename Container>
+class SmartInserter
+{
+    Container& container_;
+    ValueType last_inserted_value_;
+    typename Container::iterator last_iter_position_;
+
+public:
+    explicit SmartInserter(Container& container)
+      : container_(container), last_inserted_value_(), last_iter_position_(container.begin()) {}
+
+    void operator()(const ValueType& n)
+    {
+        auto itr = container_.begin();
+        if (n >= last_inserted_value_)
+        {
+           itr = last_iter_position_; // valid, it was returned by the last insert
+        }
+
+        for (; itr!= container_.end(); ++itr)
+        {
+            if ((*itr) >= n) {
+                break;
+            }
+        }
+        last_iter_position_ = container_.insert(itr, n);
+        last_inserted_value_ = n;
+    }
+};
+
+
+// Sort on the POD key. std::list has to use its own member sort
+template<typename Container>
+void sortContainer(Container& container)
+{
+  typedef typename Container::value_type POD_value;
+  std::sort(container.begin(), container.end(), [](const POD_value& a, const POD_value& b) { return a.a[0] < b.a[0]; });
+}
+
+template<typename ValueType>
+void sortContainer(std::list<ValueType>& list)
+{
+  list.sort([](const ValueType& a, const ValueType& b) { return a.a[0] < b.a[0]; });
+}
+
+
+// Delete of an element from a std container at 'position'.
+// The position is found with a silly linear walk, just as in linear_performance.h
+template<typename Container>
+void linearEraseAt(const Number position, Container& container)
+{
+    auto itr = container.begin();
+    for (Number idx = 0; idx != position; ++idx)
+    {
+        ++itr; // silly linear
+    }
+    container.erase(itr);
+}
+
+
+#endif // POD_PERFORMANCE_H_
+
@@ -0,0 +1,42 @@
+#ifndef RANK_PERFORMANCE_H_
+#define RANK_PERFORMANCE_H_
+
+// Insert and erase at a rank, i.e. at a position counted from the front. The positions
+// are the seeded random sequences of randomInsertPositions / randomErasePositions
+// (dataset.h), so every container does exactly the same operations.
+//
+// std::next jumps directly for the random access iterators of vector and deque, for
+// them only the memmove of the tail is left. List and unrolled list have to walk to
+// the position. The CountedBTree (counted_btree.h) finds a rank in O(log n).
+// Include "pod_performance.h" and "counted_btree.h" before this file.
+
+#include <vector>
+#include <iterator>
+
+
+template<typename Container, typename Value>
+void insertAtRank(Container& container, const Number rank, const Value& value)
+{
+  container.insert(std::next(container.begin(), rank), value);
+}
+
+template<typename Container>
+void eraseAtRank(Container& container, const Number rank)
+{
+  container.erase(std::next(container.begin(), rank));
+}
+
+template<typename T, size_t LeafCapacity, size_t Fanout>
+void insertAtRank(CountedBTree<T, LeafCapacity, Fanout>& tree, const Number rank, const T& value)
+{
+  tree.insertAt(rank, value);
+}
+
+template<typename T, size_t LeafCapacity, size_t Fanout>
+void eraseAtRank(CountedBTree<T, LeafCapacity, Fanout>& tree, const Number rank)
+{
+  tree.eraseAt(rank);
+}
+
+
+#endif // RANK_PERFORMANCE_H_
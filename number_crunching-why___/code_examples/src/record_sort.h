@@ -0,0 +1,138 @@
+#ifndef RECORD_SORT_H_
+#define RECORD_SORT_H_
+
+// Other ways to sort a vector of POD records on the key a[0]. sortContainer
+// (pod_performance.h) sorts the records themselves: every swap moves two whole
+// records, which gets expensive as the records grow. These vectors are sorted by
+// sortContainer the other way:
+//
+//   KeyIndexVector   sort (key, index) pairs, 8 bytes whatever the record size, then
+//                    gather the records in that order into a new buffer. Every record
+//                    is moved exactly once, but the gather reads them in random order
+//   RadixVector      LSD radix sort of the records on the 32-bit key, one byte per
+//                    pass, between two buffers. A pass where every key has the same
+//                    byte is skipped, keys below 2^16 take two passes. Every pass reads
+//                    and writes every record sequentially, no comparisons
+//
+// and, for inputs that are partly sorted already, two stable sorts of the records:
+//
+//   StableSortVector   std::stable_sort, a merge sort on libstdc++ that does not look
+//                      for order in the input
+//   RunMergeVector     the run-adaptive merge sort of run_merge_sort.h, linear on
+//                      sorted or reverse input
+//
+// All are a std::vector with nothing added, only sortContainer differs.
+// Include "pod_performance.h" and "run_merge_sort.h" before this file.
+
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+
+
+template<typename T>
+class KeyIndexVector : public std::vector<T>
+{
+public:
+  using std::vector<T>::vector;
+  KeyIndexVector() {}
+};
+
+template<typename T>
+class RadixVector : public std::vector<T>
+{
+public:
+  using std::vector<T>::vector;
+  RadixVector() {}
+};
+
+template<typename T>
+class StableSortVector : public std::vector<T>
+{
+public:
+  using std::vector<T>::vector;
+  StableSortVector() {}
+};
+
+template<typename T>
+class RunMergeVector : public std::vector<T>
+{
+public:
+  using std::vector<T>::vector;
+  RunMergeVector() {}
+};
+
+
+template<typename ValueType>
+void sortContainer(KeyIndexVector<ValueType>& records)
+{
+  std::vector<std::pair<Number, uint32_t>> keys(records.size());
+  for (size_t index = 0; index != records.size(); ++index) {
+    keys[index] = std::make_pair(records[index].a[0], uint32_t(index));
+  }
+  std::sort(keys.begin(), keys.end()); // on the index too, i.e. stable
+
+  std::vector<ValueType> sorted;
+  sorted.reserve(records.size());
+  for (auto& key : keys) {
+    sorted.push_back(records[key.second]);
+  }
+  records.swap(sorted);
+}
+
+template<typename ValueType>
+void sortContainer(RadixVector<ValueType>& records)
+{
+  if (records.empty()) {
+    return;
+  }
+  const size_t kDigits = sizeof(Number);
+  size_t counts[kDigits][256] = {{0}};
+  for (auto& record : records)
+  {
+    for (size_t digit = 0; digit != kDigits; ++digit) {
+      ++counts[digit][(record.a[0] >> (8 * digit)) & 0xFF];
+    }
+  }
+
+  std::vector<ValueType> buffer(records.size());
+  ValueType* from = records.data();
+  ValueType* to = buffer.data();
+  for (size_t digit = 0; digit != kDigits; ++digit)
+  {
+    size_t* count = counts[digit];
+    if (records.size() == count[(from[0].a[0] >> (8 * digit)) & 0xFF]) {
+      continue; // every key has the same byte here
+    }
+    size_t offset = 0;
+    for (size_t byte = 0; byte != 256; ++byte)
+    {
+      const size_t in_bucket = count[byte];
+      count[byte] = offset;
+      offset += in_bucket;
+    }
+    for (size_t index = 0; index != records.size(); ++index) {
+      to[count[(from[index].a[0] >> (8 * digit)) & 0xFF]++] = from[index];
+    }
+    std::swap(from, to);
+  }
+  if (from != records.data()) {
+    records.swap(buffer);
+  }
+}
+
+template<typename ValueType>
+void sortContainer(StableSortVector<ValueType>& records)
+{
+  std::stable_sort(records.begin(), records.end(),
+                   [](const ValueType& a, const ValueType& b) { return a.a[0] < b.a[0]; });
+}
+
+template<typename ValueType>
+void sortContainer(RunMergeVector<ValueType>& records)
+{
+  runMergeSort(records.begin(), records.end(),
+               [](const ValueType& a, const ValueType& b) { return a.a[0] < b.a[0]; });
+}
+
+#endif // RECORD_SORT_H_
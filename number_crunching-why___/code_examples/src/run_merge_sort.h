@@ -0,0 +1,170 @@
+#ifndef RUN_MERGE_SORT_H_
+#define RUN_MERGE_SORT_H_
+
+// Run-adaptive, stable merge sort in the style of powersort (Munro and Wild, the merge
+// policy of CPython's list.sort since 3.11), for inputs that are already partly sorted.
+//
+// The input is cut into its natural runs: a non-descending run is kept as it is, a
+// strictly descending run is reversed in place (strictly, so equal keys keep their
+// order). A run shorter than kMinRun is extended to kMinRun with an insertion sort.
+// The 'power' of the boundary between two neighbouring runs is the depth of that
+// boundary in a perfectly balanced merge tree over [0, n). Runs are merged as soon as
+// the power decreases, i.e. the runs are merged like a merge sort that knows where
+// the runs are: O(n log r) comparisons for r runs, O(n) for sorted or reverse input.
+//
+// A merge moves the left run to a buffer and merges it back, two neighbouring runs
+// that are already in order are not touched.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+
+const size_t kMinRun = 32;
+
+
+// The end of the natural run starting at 'first', a descending run is reversed
+template<typename RandomIterator, typename Less>
+RandomIterator naturalRun(RandomIterator first, RandomIterator last, Less less)
+{
+  RandomIterator end = first + 1;
+  if (end == last) {
+    return end;
+  }
+  if (less(*end, *first))
+  {
+    while (end != last && less(*end, *(end - 1))) {
+      ++end;
+    }
+    std::reverse(first, end);
+  }
+  else
+  {
+    while (end != last && !less(*end, *(end - 1))) {
+      ++end;
+    }
+  }
+  return end;
+}
+
+// [first, sorted) is sorted, insert every element of [sorted, last) into it
+template<typename RandomIterator, typename Less>
+void insertionSort(RandomIterator first, RandomIterator sorted, RandomIterator last, Less less)
+{
+  for (; sorted != last; ++sorted)
+  {
+    auto value = std::move(*sorted);
+    RandomIterator hole = sorted;
+    while (hole != first && less(value, *(hole - 1)))
+    {
+      *hole = std::move(*(hole - 1));
+      --hole;
+    }
+    *hole = std::move(value);
+  }
+}
+
+// Merge the sorted runs [first, middle) and [middle, last), stable
+template<typename RandomIterator, typename Less, typename T>
+void mergeRuns(RandomIterator first, RandomIterator middle, RandomIterator last,
+               std::vector<T>& buffer, Less less)
+{
+  if (!less(*middle, *(middle - 1))) {
+    return; // already in order
+  }
+  buffer.assign(std::make_move_iterator(first), std::make_move_iterator(middle));
+  auto left = buffer.begin();
+  RandomIterator right = middle;
+  RandomIterator out = first;
+  while (left != buffer.end() && right != last)
+  {
+    if (less(*right, *left)) {
+      *out++ = std::move(*right++);
+    } else {
+      *out++ = std::move(*left++);
+    }
+  }
+  std::move(left, buffer.end(), out);
+}
+
+// Power of the boundary between the runs [begin1, begin2) and [begin2, end2) of [0, n):
+// the first bit where the midpoints of the two runs, as fractions of n, differ
+unsigned nodePower(const size_t n, const size_t begin1, const size_t begin2, const size_t end2)
+{
+  const uint64_t two_n = 2 * uint64_t(n);
+  uint64_t a = uint64_t(begin1) + begin2; // twice the midpoints, in units of 1/2n
+  uint64_t b = uint64_t(begin2) + end2;
+  unsigned power = 0;
+  while (true)
+  {
+    ++power;
+    a *= 2;
+    b *= 2;
+    const bool a_bit = (a >= two_n);
+    const bool b_bit = (b >= two_n);
+    if (a_bit != b_bit) {
+      return power;
+    }
+    if (a_bit)
+    {
+      a -= two_n;
+      b -= two_n;
+    }
+  }
+}
+
+
+template<typename RandomIterator, typename Less>
+void runMergeSort(RandomIterator first, RandomIterator last, Less less)
+{
+  typedef typename std::iterator_traits<RandomIterator>::value_type T;
+  struct Run
+  {
+    size_t begin;
+    unsigned power; // of the boundary after the run
+  };
+
+  const size_t n = size_t(last - first);
+  if (n < 2) {
+    return;
+  }
+  auto nextRun = [&](const size_t begin) -> size_t {
+    RandomIterator end = naturalRun(first + begin, last, less);
+    const size_t min_end = std::min(n, begin + kMinRun);
+    if (size_t(end - first) < min_end)
+    {
+      insertionSort(first + begin, end, first + min_end, less);
+      end = first + min_end;
+    }
+    return size_t(end - first);
+  };
+
+  std::vector<Run> stack;
+  std::vector<T> buffer;
+  size_t begin = 0;
+  size_t end = nextRun(0);
+  while (end != n)
+  {
+    const size_t next_end = nextRun(end);
+    const unsigned power = nodePower(n, begin, end, next_end);
+    while (!stack.empty() && stack.back().power > power)
+    {
+      mergeRuns(first + stack.back().begin, first + begin, first + end, buffer, less);
+      begin = stack.back().begin;
+      stack.pop_back();
+    }
+    const Run run = {begin, power};
+    stack.push_back(run);
+    begin = end;
+    end = next_end;
+  }
+  while (!stack.empty())
+  {
+    mergeRuns(first + stack.back().begin, first + begin, last, buffer, less);
+    begin = stack.back().begin;
+    stack.pop_back();
+  }
+}
+
+#endif // RUN_MERGE_SORT_H_
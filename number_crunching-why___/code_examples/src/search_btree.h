@@ -0,0 +1,231 @@
+#ifndef SEARCH_BTREE_H_
+#define SEARCH_BTREE_H_
+
+// Static B+tree for lookups on a key: built once from a range of values and then only
+// searched. Every node is its own heap allocation, so a search is a chain of
+// dependent loads from the root to a leaf, one node per level, like any pointer based
+// tree. Only the node's keys are scanned: an inner node keeps the largest key of each
+// child, a leaf keeps the keys of its values apart from the values.
+//
+// The counted B+tree (counted_btree.h) is searched by rank and has no keys in its
+// inner nodes, this one is searched by key. Search is the step by step form of
+// lowerBound: a search that can be suspended after every node, for the interleaved
+// lookups in batched_lookup.h.
+
+#include <cstddef>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+
+
+template<typename Key, typename Value, size_t Fanout = 16>
+class SearchBTree
+{
+  static_assert(Fanout >= 2, "a node needs at least two children");
+
+  struct Node
+  {
+    bool is_leaf;
+    size_t nbr;
+    Key keys[Fanout];
+
+    explicit Node(bool leaf) : is_leaf(leaf), nbr(0) {}
+
+    // Index of the first key >= 'key', 'nbr' if there is none
+    size_t lowerBound(const Key& key) const
+    {
+      size_t index = 0;
+      while (index != nbr && keys[index] < key) {
+        ++index;
+      }
+      return index;
+    }
+  };
+
+  struct Leaf : Node
+  {
+    Value values[Fanout];
+    Leaf() : Node(true) {}
+  };
+
+  struct Inner : Node
+  {
+    const Node* children[Fanout];
+    Inner() : Node(false) {}
+  };
+
+  std::vector<Leaf*> leaves_;   // in key order
+  std::vector<Inner*> inners_;  // owned, the root is the last one
+  const Node* root_;
+  size_t inner_levels_;         // above the leaves, all leaves are at the same depth
+  size_t size_;
+
+  void destroy()
+  {
+    for (auto leaf : leaves_) {
+      delete leaf;
+    }
+    for (auto inner : inners_) {
+      delete inner;
+    }
+    leaves_.clear();
+    inners_.clear();
+    root_ = nullptr;
+    inner_levels_ = 0;
+    size_ = 0;
+  }
+
+public:
+  // One lookup, one node at a time. start() and then step() until it returns true,
+  // between two steps the node that is read next is pending(), pendingBytes() long.
+  // The search counts the levels, so it knows whether that is a leaf or an inner node
+  // before the node is loaded
+  class Search
+  {
+    const Node* node_;
+    const Value* found_;
+    size_t inner_levels_;  // left to go through before the leaf
+    Key key_;
+
+  public:
+    Search() : node_(nullptr), found_(nullptr), inner_levels_(0), key_() {}
+
+    void start(const SearchBTree& tree, const Key& key)
+    {
+      node_ = tree.root_;
+      found_ = nullptr;
+      inner_levels_ = tree.inner_levels_;
+      key_ = key;
+    }
+
+    bool step()
+    {
+      if (nullptr == node_) {
+        return true;
+      }
+      const size_t index = node_->lowerBound(key_);
+      if (index == node_->nbr)
+      {
+        node_ = nullptr; // larger than every key
+        return true;
+      }
+      if (node_->is_leaf)
+      {
+        found_ = &static_cast<const Leaf*>(node_)->values[index];
+        node_ = nullptr;
+        return true;
+      }
+      node_ = static_cast<const Inner*>(node_)->children[index];
+      --inner_levels_;
+      return false;
+    }
+
+    const void* pending() const { return node_; }
+    size_t pendingBytes() const { return (0 == inner_levels_) ? sizeof(Leaf) : sizeof(Inner); }
+
+    // The first value with a key >= the searched key, nullptr if there is none
+    const Value* found() const { return found_; }
+  };
+
+  template<typename ValueOf>
+  class IteratorOf
+  {
+    friend class SearchBTree;
+    const Leaf* const* leaf_;
+    size_t index_;
+
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Value value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef ValueOf* pointer;
+    typedef ValueOf& reference;
+
+    IteratorOf(const Leaf* const* leaf = nullptr, size_t index = 0) : leaf_(leaf), index_(index) {}
+
+    ValueOf& operator*() const  { return (*leaf_)->values[index_]; }
+    ValueOf* operator->() const { return &(*leaf_)->values[index_]; }
+    IteratorOf& operator++()
+    {
+      if (++index_ == (*leaf_)->nbr) {
+        ++leaf_;
+        index_ = 0;
+      }
+      return *this;
+    }
+    IteratorOf operator++(int) { IteratorOf before(*this); ++(*this); return before; }
+    bool operator==(const IteratorOf& other) const { return leaf_ == other.leaf_ && index_ == other.index_; }
+    bool operator!=(const IteratorOf& other) const { return !(*this == other); }
+  };
+
+  typedef Value value_type;
+  typedef IteratorOf<const Value> const_iterator;
+
+  SearchBTree() : root_(nullptr), inner_levels_(0), size_(0) {}
+  ~SearchBTree() { destroy(); }
+
+  SearchBTree(const SearchBTree&) = delete;
+  SearchBTree& operator=(const SearchBTree&) = delete;
+
+  const_iterator begin() const { return const_iterator(leaves_.data(), 0); }
+  const_iterator end() const   { return const_iterator(leaves_.data() + leaves_.size(), 0); }
+
+  size_t size() const { return size_; }
+  bool empty() const  { return 0 == size_; }
+
+  // Build from the values in [first, last), in any order. 'key_of' gives the key of a value
+  template<typename InputIterator, typename KeyOf>
+  void assign(InputIterator first, InputIterator last, KeyOf key_of)
+  {
+    destroy();
+    std::vector<Value> values(first, last);
+    std::stable_sort(values.begin(), values.end(),
+                     [&](const Value& a, const Value& b) { return key_of(a) < key_of(b); });
+    size_ = values.size();
+
+    std::vector<const Node*> level;
+    for (size_t begin = 0; begin < values.size(); begin += Fanout)
+    {
+      Leaf* leaf = new Leaf;
+      leaf->nbr = std::min(Fanout, values.size() - begin);
+      for (size_t idx = 0; idx != leaf->nbr; ++idx)
+      {
+        leaf->values[idx] = values[begin + idx];
+        leaf->keys[idx] = key_of(values[begin + idx]);
+      }
+      leaves_.push_back(leaf);
+      level.push_back(leaf);
+    }
+    while (level.size() > 1)
+    {
+      std::vector<const Node*> parents;
+      for (size_t begin = 0; begin < level.size(); begin += Fanout)
+      {
+        Inner* inner = new Inner;
+        inner->nbr = std::min(Fanout, level.size() - begin);
+        for (size_t idx = 0; idx != inner->nbr; ++idx)
+        {
+          const Node* child = level[begin + idx];
+          inner->children[idx] = child;
+          inner->keys[idx] = child->keys[child->nbr - 1];
+        }
+        inners_.push_back(inner);
+        parents.push_back(inner);
+      }
+      level.swap(parents);
+      ++inner_levels_;
+    }
+    root_ = level.empty() ? nullptr : level.front();
+  }
+
+  // The first value with a key >= 'key', nullptr if there is none
+  const Value* lowerBound(const Key& key) const
+  {
+    Search search;
+    search.start(*this, key);
+    while (!search.step()) {}
+    return search.found();
+  }
+};
+
+#endif // SEARCH_BTREE_H_
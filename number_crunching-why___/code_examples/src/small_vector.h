@@ -0,0 +1,129 @@
+#ifndef SMALL_VECTOR_H_
+#define SMALL_VECTOR_H_
+
+// Small-buffer vector: the first 'InlineCapacity' elements live inside the object
+// itself (no heap allocation at all). When that is exceeded the elements are moved
+// to a heap buffer that grows by doubling, just like std::vector.
+//
+// Only what the linear insert/erase tests need is implemented: iterators are plain
+// pointers, insert/erase at an iterator position, push_back, size, empty and clear.
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+
+template<typename T, size_t InlineCapacity>
+class SmallVector
+{
+  static_assert(InlineCapacity > 0, "SmallVector needs at least one inline element");
+  typedef typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type Slot;
+
+  Slot inline_[InlineCapacity];
+  T* data_;
+  size_t size_;
+  size_t capacity_;
+
+  bool isInline() const { return data_ == reinterpret_cast<const T*>(inline_); }
+
+  // move all elements to a heap buffer with room for 'new_capacity' elements
+  void grow(size_t new_capacity)
+  {
+    T* heap = static_cast<T*>(::operator new(new_capacity * sizeof(T)));
+    for (size_t idx = 0; idx != size_; ++idx)
+    {
+      new (heap + idx) T(std::move(data_[idx]));
+      data_[idx].~T();
+    }
+    if (!isInline()) {
+      ::operator delete(data_);
+    }
+    data_ = heap;
+    capacity_ = new_capacity;
+  }
+
+public:
+  typedef T value_type;
+  typedef T* iterator;
+  typedef const T* const_iterator;
+
+  SmallVector() : data_(reinterpret_cast<T*>(inline_)), size_(0), capacity_(InlineCapacity) {}
+  ~SmallVector()
+  {
+    clear();
+    if (!isInline()) {
+      ::operator delete(data_);
+    }
+  }
+
+  // The benchmarks never copy their containers, keep it that way
+  SmallVector(const SmallVector&) = delete;
+  SmallVector& operator=(const SmallVector&) = delete;
+
+  iterator begin()              { return data_; }
+  iterator end()                { return data_ + size_; }
+  const_iterator begin() const  { return data_; }
+  const_iterator end() const    { return data_ + size_; }
+  const T* data() const         { return data_; }
+
+  size_t size() const           { return size_; }
+  size_t capacity() const       { return capacity_; }
+  bool empty() const            { return 0 == size_; }
+  bool onHeap() const           { return !isInline(); }
+
+  T& operator[](size_t idx)             { return data_[idx]; }
+  const T& operator[](size_t idx) const { return data_[idx]; }
+
+  void reserve(size_t wanted)
+  {
+    if (wanted > capacity_) {
+      grow(wanted);
+    }
+  }
+
+  void push_back(const T& value)
+  {
+    insert(end(), value);
+  }
+
+  // Insert before 'pos'. Elements after 'pos' are shifted one step to the right
+  iterator insert(iterator pos, const T& value)
+  {
+    const size_t index = pos - data_;
+    T copy(value); // 'value' might be one of our own elements that is about to move
+    if (size_ == capacity_) {
+      grow(capacity_ * 2);
+    }
+
+    if (index == size_) {
+      new (data_ + size_) T(std::move(copy));
+    } else {
+      new (data_ + size_) T(std::move(data_[size_ - 1]));
+      std::move_backward(data_ + index, data_ + size_ - 1, data_ + size_);
+      data_[index] = std::move(copy);
+    }
+    ++size_;
+    return data_ + index;
+  }
+
+  // Erase at 'pos'. Elements after 'pos' are shifted one step to the left
+  iterator erase(iterator pos)
+  {
+    std::move(pos + 1, data_ + size_, pos);
+    --size_;
+    data_[size_].~T();
+    return pos;
+  }
+
+  void clear()
+  {
+    for (size_t idx = 0; idx != size_; ++idx) {
+      data_[idx].~T();
+    }
+    size_ = 0;
+  }
+};
+
+#endif // SMALL_VECTOR_H_
@@ -0,0 +1,273 @@
+#ifndef SORTED_LAYOUTS_H_
+#define SORTED_LAYOUTS_H_
+
+// Build-once array layouts of sorted data for read mostly sets. Both store the keys
+// of an implicit binary search tree in an array, no pointers, and search it without
+// a branch on the comparison (the comparison result is added to the index).
+//
+//   EytzingerArray   the tree in BFS order: the root at 1, the children of k at 2k and
+//                    2k+1. The 16 descendants four levels below k are the 16 keys at
+//                    16k, i.e. one cache line of 4 byte keys, which is prefetched at
+//                    every step. The first levels are shared by every search and stay
+//                    in the cache
+//   VebArray         van Emde Boas order: the top half of the levels is laid out
+//                    first, then every subtree below it, each of them recursively the
+//                    same way. A subtree that fits in a cache line (or a page) is read
+//                    from that line only, whatever the line size, the layout is cache
+//                    oblivious. The tree is completed with padding after the largest
+//                    key, the position of a node is computed from per level tables
+//                    (Brodal, Fagerberg and Jacob)
+//
+// The values are kept in the same order as the keys, in an array of their own. Both
+// are built with assign() like FlatMap, lowerBound(key) gives the first value with a
+// key >= key. Compare a binary search (std::lower_bound) of the sorted order, that
+// jumps through the whole array in the first steps, a miss per step on a large array.
+// Include "cache_mode.h" before this file.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+
+// Keys aligned on a cache line for the Eytzinger prefetch, 'Key' is an integral type
+template<typename Key>
+class AlignedKeys
+{
+  std::vector<Key> storage_;
+  Key* keys_;
+
+public:
+  AlignedKeys() : keys_(nullptr) {}
+
+  void assign(size_t count, const Key& key)
+  {
+    const size_t kLine = 64;
+    storage_.assign(count + kLine / sizeof(Key), key);
+    const uintptr_t address = reinterpret_cast<uintptr_t>(storage_.data());
+    keys_ = storage_.data() + ((kLine - address % kLine) % kLine) / sizeof(Key);
+  }
+
+  Key& operator[](size_t index)             { return keys_[index]; }
+  const Key& operator[](size_t index) const { return keys_[index]; }
+  const Key* data() const { return keys_; }
+};
+
+
+// The values in [first, last) sorted on their key
+template<typename Value, typename InputIterator, typename KeyOf>
+std::vector<Value> sortedOnKey(InputIterator first, InputIterator last, KeyOf key_of)
+{
+  std::vector<Value> values(first, last);
+  std::stable_sort(values.begin(), values.end(),
+                   [&](const Value& a, const Value& b) { return key_of(a) < key_of(b); });
+  return values;
+}
+
+// In-order walk of the BFS indexes [1, count]: 'visit(bfs_index, sorted_rank)'
+template<typename Visit>
+void inOrderBfs(const size_t count, Visit visit)
+{
+  std::vector<size_t> stack;
+  size_t rank = 0;
+  size_t index = 1;
+  while (index <= count || !stack.empty())
+  {
+    while (index <= count)
+    {
+      stack.push_back(index);
+      index = 2 * index;
+    }
+    index = stack.back();
+    stack.pop_back();
+    visit(index, rank++);
+    index = 2 * index + 1;
+  }
+}
+
+
+template<typename Key, typename Value>
+class EytzingerArray
+{
+  AlignedKeys<Key> keys_;     // [1, size], keys_[0] is unused
+  std::vector<Value> values_; // same order
+  size_t size_;
+
+public:
+  typedef Value value_type;
+  typedef typename std::vector<Value>::const_iterator const_iterator;
+
+  EytzingerArray() : size_(0) {}
+
+  EytzingerArray(const EytzingerArray&) = delete;
+  EytzingerArray& operator=(const EytzingerArray&) = delete;
+
+  // In layout order, not in key order
+  const_iterator begin() const { return values_.begin() + 1; }
+  const_iterator end() const   { return values_.end(); }
+
+  size_t size() const { return size_; }
+  bool empty() const  { return 0 == size_; }
+
+  // Build from the values in [first, last), in any order. 'key_of' gives the key of a value
+  template<typename InputIterator, typename KeyOf>
+  void assign(InputIterator first, InputIterator last, KeyOf key_of)
+  {
+    const std::vector<Value> sorted = sortedOnKey<Value>(first, last, key_of);
+    size_ = sorted.size();
+    keys_.assign(size_ + 1, Key());
+    values_.assign(size_ + 1, Value());
+    inOrderBfs(size_, [&](size_t index, size_t rank) {
+      keys_[index] = key_of(sorted[rank]);
+      values_[index] = sorted[rank];
+    });
+  }
+
+  // The first value with a key >= 'key', nullptr if there is none
+  const Value* lowerBound(const Key& key) const
+  {
+    const Key* keys = keys_.data();
+    size_t index = 1;
+    while (index <= size_)
+    {
+      prefetchLines(keys + 16 * index, sizeof(Key)); // four levels down, may be past the end
+      index = 2 * index + (keys[index] < key);
+    }
+    // undo the right turns after the last left turn, that node is the lower bound
+    while (index & 1) {
+      index >>= 1;
+    }
+    index >>= 1;
+    return (0 == index) ? nullptr : &values_[index];
+  }
+};
+
+
+template<typename Key, typename Value>
+class VebArray
+{
+  // Per depth d > 0: d is the first level of the bottom trees of the split of a
+  // subtree rooted at depth 'top_depth'. 'top_size' and 'bottom_size' are the node
+  // counts of the top tree and of each bottom tree of that split
+  struct Level
+  {
+    size_t top_depth;
+    size_t top_size;
+    size_t bottom_size;
+  };
+
+  std::vector<Key> keys_;
+  std::vector<Value> values_;
+  std::vector<Level> levels_;
+  size_t height_;
+  size_t size_;
+  size_t nbr_of_slots_;      // 2^height - 1, the padding included
+  Key last_key_;
+
+  void split(const size_t root_depth, const size_t height)
+  {
+    if (height <= 1) {
+      return;
+    }
+    const size_t top = height / 2;
+    const size_t bottom = height - top;
+    Level& level = levels_[root_depth + top];
+    level.top_depth = root_depth;
+    level.top_size = (size_t(1) << top) - 1;
+    level.bottom_size = (size_t(1) << bottom) - 1;
+    split(root_depth, top);
+    split(root_depth + top, bottom);
+  }
+
+  // Position of the node at 'depth' with BFS index 'index', given the positions of
+  // its ancestors in 'positions'
+  size_t position(const size_t* positions, const size_t depth, const size_t index) const
+  {
+    const Level& level = levels_[depth];
+    const size_t subtree = index & ((size_t(1) << (depth - level.top_depth)) - 1);
+    return positions[level.top_depth] + level.top_size + subtree * level.bottom_size;
+  }
+
+public:
+  typedef Value value_type;
+  typedef typename std::vector<Value>::const_iterator const_iterator;
+
+  VebArray() : height_(0), size_(0), nbr_of_slots_(0), last_key_() {}
+
+  VebArray(const VebArray&) = delete;
+  VebArray& operator=(const VebArray&) = delete;
+
+  // In layout order and with the padding, not in key order
+  const_iterator begin() const { return values_.begin(); }
+  const_iterator end() const   { return values_.end(); }
+
+  size_t size() const { return size_; }
+  bool empty() const  { return 0 == size_; }
+
+  // Build from the values in [first, last), in any order. 'key_of' gives the key of a value
+  template<typename InputIterator, typename KeyOf>
+  void assign(InputIterator first, InputIterator last, KeyOf key_of)
+  {
+    const std::vector<Value> sorted = sortedOnKey<Value>(first, last, key_of);
+    size_ = sorted.size();
+    height_ = 0;
+    while ((size_t(1) << height_) - 1 < size_) {
+      ++height_;
+    }
+    nbr_of_slots_ = (size_t(1) << height_) - 1;
+    levels_.assign(height_ + 1, Level());
+    split(0, height_);
+
+    // the padding has the largest key and sorts after every real key
+    last_key_ = sorted.empty() ? Key() : key_of(sorted.back());
+    keys_.assign(nbr_of_slots_, last_key_);
+    values_.assign(nbr_of_slots_, Value());
+    std::vector<size_t> ranks(nbr_of_slots_ + 1);
+    inOrderBfs(nbr_of_slots_, [&](size_t index, size_t rank) { ranks[index] = rank; });
+
+    size_t positions[64] = {0};
+    for (size_t index = 1; index <= nbr_of_slots_; ++index)
+    {
+      size_t depth = 0;
+      while ((index >> depth) > 1) {
+        ++depth;
+      }
+      for (size_t ancestor = 1; ancestor <= depth; ++ancestor) {
+        positions[ancestor] = position(positions, ancestor, index >> (depth - ancestor));
+      }
+      const size_t rank = ranks[index];
+      if (rank < size_)
+      {
+        keys_[positions[depth]] = key_of(sorted[rank]);
+        values_[positions[depth]] = sorted[rank];
+      }
+    }
+  }
+
+  // The first value with a key >= 'key', nullptr if there is none
+  const Value* lowerBound(const Key& key) const
+  {
+    if (0 == size_ || last_key_ < key) {
+      return nullptr; // else the lower bound is a real key, never the padding
+    }
+    size_t positions[64];
+    positions[0] = 0;
+    size_t index = 1;
+    size_t found = 0;
+    for (size_t depth = 0; ; )
+    {
+      const size_t at = positions[depth];
+      const bool right = keys_[at] < key;
+      found = right ? found : at;
+      index = 2 * index + right;
+      if (++depth == height_) {
+        break;
+      }
+      positions[depth] = position(positions, depth, index);
+    }
+    return &values_[found];
+  }
+};
+
+#endif // SORTED_LAYOUTS_H_
@@ -0,0 +1,236 @@
+#ifndef STREAM_INGEST_H_
+#define STREAM_INGEST_H_
+
+// Streaming ingest: the numbers arrive as text, from a file or a pipe, and are inserted
+// while the rest is still being read, the way keys reach a service. Nothing is
+// generated up front.
+//
+// A producer thread parses the text into chunks of numbers. The consumer, the calling
+// thread, inserts every chunk with linearInsertion as soon as it is handed over. The
+// chunks are double buffered (kStreamChunks): the producer fills one chunk while the
+// consumer inserts the other, parsing and inserting overlap and at most two chunks are
+// in flight. A side that finds no chunk to work on waits, the report has how long.
+//
+// The queue depth is the number of parsed chunks that are already waiting when the
+// consumer asks for the next one, before it waits for one: 0 when it has to wait. Close
+// to 0: the inserts wait for the parser. Close to kStreamChunks: the parser waits for
+// the inserts.
+//
+// Any character that is not a digit separates two numbers, e.g. one number per line.
+// Include "g2_chrono.h" and "linear_performance.h" before this file.
+
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+
+const size_t kStreamChunks = 2;
+
+
+// The hand-over of chunks between the producer and the consumer
+class ChunkQueue
+{
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::vector<NumbersInVector> chunks_;
+  std::vector<NumbersInVector*> free_;
+  std::deque<NumbersInVector*> filled_;   // in the order they were parsed
+  bool closed_;
+  TimeValue producer_wait_us_;
+  TimeValue consumer_wait_us_;
+
+public:
+  ChunkQueue(const size_t nbr_of_chunks, const size_t chunk_size)
+    : chunks_(nbr_of_chunks), closed_(false), producer_wait_us_(0), consumer_wait_us_(0)
+  {
+    for (auto& chunk : chunks_)
+    {
+      chunk.reserve(chunk_size);
+      free_.push_back(&chunk);
+    }
+  }
+
+  ChunkQueue(const ChunkQueue&) = delete;
+  ChunkQueue& operator=(const ChunkQueue&) = delete;
+
+  // Producer: an empty chunk, waits until the consumer has released one
+  NumbersInVector* takeFree()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (free_.empty())
+    {
+      g2::StopWatch watch;
+      changed_.wait(lock, [this]() { return !free_.empty(); });
+      producer_wait_us_ += watch.elapsedUs().count();
+    }
+    NumbersInVector* chunk = free_.back();
+    free_.pop_back();
+    return chunk;
+  }
+
+  // Producer: hand over a parsed chunk
+  void pushFilled(NumbersInVector* chunk)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      filled_.push_back(chunk);
+    }
+    changed_.notify_all();
+  }
+
+  // Producer: no more chunks will come
+  void close()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+    }
+    changed_.notify_all();
+  }
+
+  // Consumer: the next parsed chunk, nullptr when the input is done. 'depth' is the
+  // number of parsed chunks that were waiting on the call, 0 when the consumer had to
+  // wait for the chunk it gets
+  NumbersInVector* takeFilled(size_t& depth)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    depth = filled_.size();
+    if (filled_.empty() && !closed_)
+    {
+      g2::StopWatch watch;
+      changed_.wait(lock, [this]() { return !filled_.empty() || closed_; });
+      consumer_wait_us_ += watch.elapsedUs().count();
+    }
+    if (filled_.empty()) {
+      return nullptr;
+    }
+    NumbersInVector* chunk = filled_.front();
+    filled_.pop_front();
+    return chunk;
+  }
+
+  // Consumer or producer: give back a chunk for the producer to fill
+  void release(NumbersInVector* chunk)
+  {
+    chunk->clear();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      free_.push_back(chunk);
+    }
+    changed_.notify_all();
+  }
+
+  // Only when both sides are done
+  TimeValue producerWaitUs() const { return producer_wait_us_; }
+  TimeValue consumerWaitUs() const { return consumer_wait_us_; }
+};
+
+
+// Producer: parse the unsigned decimal numbers of 'in' into chunks of 'chunk_size'
+void produceChunks(std::istream& in, ChunkQueue& queue, const size_t chunk_size)
+{
+  std::vector<char> buffer(64 * 1024);
+  NumbersInVector* chunk = queue.takeFree();
+  Number number = 0;
+  bool in_number = false;
+  while (in)
+  {
+    in.read(buffer.data(), std::streamsize(buffer.size()));
+    const size_t got = size_t(in.gcount());
+    for (size_t idx = 0; idx != got; ++idx)
+    {
+      const char c = buffer[idx];
+      if (c >= '0' && c <= '9')
+      {
+        number = 10 * number + Number(c - '0');
+        in_number = true;
+        continue;
+      }
+      if (!in_number) {
+        continue;
+      }
+      chunk->push_back(number);
+      number = 0;
+      in_number = false;
+      if (chunk->size() == chunk_size)
+      {
+        queue.pushFilled(chunk);
+        chunk = queue.takeFree();
+      }
+    }
+  }
+  if (in_number) {
+    chunk->push_back(number);
+  }
+  if (chunk->empty()) {
+    queue.release(chunk);
+  } else {
+    queue.pushFilled(chunk);
+  }
+  queue.close();
+}
+
+
+struct StreamReport
+{
+  size_t numbers;
+  size_t chunks;
+  size_t depth_sum;        // over all chunks, for the average
+  size_t max_depth;
+  TimeValue elapsed_us;    // end to end: first byte read to last number inserted
+  TimeValue producer_wait_us;
+  TimeValue consumer_wait_us;
+
+  StreamReport() : numbers(0), chunks(0), depth_sum(0), max_depth(0), elapsed_us(0)
+                 , producer_wait_us(0), consumer_wait_us(0) {}
+};
+
+// Parse 'in' on a producer thread and insert every number into 'container' as the
+// chunks arrive
+template<typename Container>
+StreamReport streamIngest(std::istream& in, Container& container, const size_t chunk_size)
+{
+  StreamReport report;
+  ChunkQueue queue(kStreamChunks, chunk_size);
+  g2::StopWatch watch;
+  std::thread producer([&]() { produceChunks(in, queue, chunk_size); });
+  size_t depth = 0;
+  while (NumbersInVector* chunk = queue.takeFilled(depth))
+  {
+    report.depth_sum += depth;
+    report.max_depth = std::max(report.max_depth, depth);
+    ++report.chunks;
+    report.numbers += chunk->size();
+    linearInsertion(*chunk, container);
+    queue.release(chunk);
+  }
+  producer.join();
+  report.elapsed_us = watch.elapsedUs().count();
+  report.producer_wait_us = queue.producerWaitUs();
+  report.consumer_wait_us = queue.consumerWaitUs();
+  return report;
+}
+
+void printStreamReport(const StreamReport& report, const std::string& container, std::ostream& out)
+{
+  const double seconds = double(std::max(report.elapsed_us, TimeValue(1))) / 1000000;
+  const double average_depth = (0 == report.chunks) ? 0 : double(report.depth_sum) / double(report.chunks);
+  out << "Streamed " << report.numbers << " numbers into " << container << " in " << report.chunks;
+  out << " chunks, " << report.elapsed_us / 1000 << " ms end to end" << std::endl;
+  out << std::fixed << std::setprecision(2);
+  out << "throughput: " << double(report.numbers) / seconds << " numbers/s" << std::endl;
+  out << "queue depth (parsed chunks waiting, " << kStreamChunks << " buffers): average " << average_depth;
+  out << ", max " << report.max_depth << std::endl;
+  out.unsetf(std::ios::floatfield);
+  out << "waited: consumer for input " << report.consumer_wait_us / 1000 << " ms, producer for a free chunk ";
+  out << report.producer_wait_us / 1000 << " ms" << std::endl;
+}
+
+#endif // STREAM_INGEST_H_
@@ -0,0 +1,213 @@
+#ifndef UNROLLED_LIST_H_
+#define UNROLLED_LIST_H_
+
+// Unrolled linked list: a doubly linked list of nodes where every node holds an array
+// of up to 'NodeCapacity' elements. Walking it is a sequential scan within a node and
+// one pointer hop per node, inserting and erasing only shifts the elements of one node.
+// The middle ground between std::list (one element per node) and std::vector (one node).
+//
+// A full node is split in two halves. Appending at the very end starts a new node
+// instead, so a list that is built front to back is densely packed. A node that falls
+// below half full is merged with the next node when they fit in one. Half, not less:
+// a node of 4 elements, e.g. POD<64> in 1KB, would never be below a quarter full.
+//
+// Only for trivially copyable types, elements are shifted with memmove. Only what the
+// linear insert/erase tests need is implemented: forward iterators, insert/erase at an
+// iterator position, push_back, size, empty and clear.
+//
+// UnrolledNodeCapacity<T, Bytes>::value gives the capacity of a node with 'Bytes' of
+// elements, e.g. 1024 bytes = 16 cache lines.
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <iterator>
+#include <type_traits>
+
+
+template<typename T, size_t Bytes>
+struct UnrolledNodeCapacity
+{
+  static const size_t value = (Bytes / sizeof(T) > 1) ? Bytes / sizeof(T) : 2;
+};
+
+
+template<typename T, size_t NodeCapacity>
+class UnrolledList
+{
+  static_assert(std::is_trivially_copyable<T>::value, "UnrolledList shifts elements with memmove");
+  static_assert(NodeCapacity >= 2, "a node must be able to split in two");
+
+  struct Node
+  {
+    Node* next;
+    Node* prev;
+    size_t count;
+    typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type slots[NodeCapacity];
+
+    T* elements() { return reinterpret_cast<T*>(slots); }
+  };
+
+  Node* head_;
+  Node* tail_;
+  size_t size_;
+
+  Node* createAfter(Node* node)
+  {
+    Node* created = new Node;
+    created->count = 0;
+    created->prev = node;
+    created->next = (nullptr == node) ? head_ : node->next;
+    if (nullptr != created->next) {
+      created->next->prev = created;
+    } else {
+      tail_ = created;
+    }
+    if (nullptr != node) {
+      node->next = created;
+    } else {
+      head_ = created;
+    }
+    return created;
+  }
+
+  void unlink(Node* node)
+  {
+    (nullptr != node->prev ? node->prev->next : head_) = node->next;
+    (nullptr != node->next ? node->next->prev : tail_) = node->prev;
+    delete node;
+  }
+
+public:
+  template<typename Value>
+  class IteratorOf
+  {
+    friend class UnrolledList;
+    Node* node_;
+    size_t index_;
+
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Value* pointer;
+    typedef Value& reference;
+
+    IteratorOf(Node* node = nullptr, size_t index = 0) : node_(node), index_(index) {}
+
+    Value& operator*() const  { return node_->elements()[index_]; }
+    Value* operator->() const { return &node_->elements()[index_]; }
+    IteratorOf& operator++()
+    {
+      if (++index_ == node_->count) {
+        node_ = node_->next;
+        index_ = 0;
+      }
+      return *this;
+    }
+    IteratorOf operator++(int) { IteratorOf before(*this); ++(*this); return before; }
+    bool operator==(const IteratorOf& other) const { return node_ == other.node_ && index_ == other.index_; }
+    bool operator!=(const IteratorOf& other) const { return !(*this == other); }
+  };
+
+  typedef T value_type;
+  typedef IteratorOf<T> iterator;
+  typedef IteratorOf<const T> const_iterator;
+
+  UnrolledList() : head_(nullptr), tail_(nullptr), size_(0) {}
+
+  template<typename InputIterator>
+  UnrolledList(InputIterator first, InputIterator last) : head_(nullptr), tail_(nullptr), size_(0)
+  {
+    for (; first != last; ++first) {
+      push_back(*first);
+    }
+  }
+
+  ~UnrolledList() { clear(); }
+
+  UnrolledList(const UnrolledList&) = delete;
+  UnrolledList& operator=(const UnrolledList&) = delete;
+
+  iterator begin() { return iterator(head_, 0); }
+  iterator end()   { return iterator(); }
+  const_iterator begin() const { return const_iterator(head_, 0); }
+  const_iterator end() const   { return const_iterator(); }
+
+  size_t size() const { return size_; }
+  bool empty() const  { return 0 == size_; }
+
+  void clear()
+  {
+    while (nullptr != head_)
+    {
+      Node* next = head_->next;
+      delete head_;
+      head_ = next;
+    }
+    tail_ = nullptr;
+    size_ = 0;
+  }
+
+  void push_back(const T& value) { insert(end(), value); }
+
+  // Insert before 'position', returns the position of the inserted element
+  iterator insert(iterator position, const T& value)
+  {
+    Node* node = position.node_;
+    size_t index = position.index_;
+    if (nullptr == node)
+    {
+      // at the end: append to the last node, or start a new one when it is full
+      node = (nullptr == tail_ || NodeCapacity == tail_->count) ? createAfter(tail_) : tail_;
+      index = node->count;
+    }
+    else if (NodeCapacity == node->count)
+    {
+      const size_t half = NodeCapacity / 2;
+      Node* upper = createAfter(node);
+      std::memcpy(upper->elements(), node->elements() + half, (NodeCapacity - half) * sizeof(T));
+      upper->count = NodeCapacity - half;
+      node->count = half;
+      if (index > half) {
+        node = upper;
+        index -= half;
+      }
+    }
+
+    T* elements = node->elements();
+    std::memmove(elements + index + 1, elements + index, (node->count - index) * sizeof(T));
+    new (elements + index) T(value);
+    ++node->count;
+    ++size_;
+    return iterator(node, index);
+  }
+
+  // Returns the position of the element after the erased one
+  iterator erase(iterator position)
+  {
+    Node* node = position.node_;
+    const size_t index = position.index_;
+    T* elements = node->elements();
+    std::memmove(elements + index, elements + index + 1, (node->count - index - 1) * sizeof(T));
+    --node->count;
+    --size_;
+
+    if (0 == node->count)
+    {
+      Node* next = node->next;
+      unlink(node);
+      return iterator(next, 0);
+    }
+    Node* next = node->next;
+    if (2 * node->count < NodeCapacity && nullptr != next && node->count + next->count <= NodeCapacity)
+    {
+      std::memcpy(elements + node->count, next->elements(), next->count * sizeof(T));
+      node->count += next->count;
+      unlink(next);
+    }
+    return (index == node->count) ? iterator(node->next, 0) : iterator(node, index);
+  }
+};
+
+#endif // UNROLLED_LIST_H_